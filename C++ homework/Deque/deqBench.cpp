@@ -0,0 +1,155 @@
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <deque>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "deque.h"
+
+// Throughput and peak RSS of Deque against std::deque and std::vector.
+// Every case runs in its own forked process so that ru_maxrss is per case.
+
+constexpr size_t kEndsOps = 2'000'000;
+constexpr size_t kAccessSize = 1'000'000;
+constexpr size_t kMiddleSize = 100'000;
+constexpr size_t kMiddleOps = 2'000;
+constexpr size_t kCopySize = 1'000'000;
+
+struct Heavy {
+  std::string name = "heavy element with a heap allocated name";
+  std::array<long long, 6> payload = {};
+
+  Heavy() = default;
+  Heavy(size_t value) { payload[0] = value; }
+  operator size_t() const { return payload[0]; }
+};
+
+template <typename Container>
+constexpr bool kHasFront = requires(Container c) { c.push_front(c[0]); };
+
+volatile size_t sink = 0;
+
+template <typename Container>
+size_t PushPopBack() {
+  Container c;
+  for (size_t i = 0; i < kEndsOps; ++i) {
+    c.push_back(i);
+  }
+  for (size_t i = 0; i < kEndsOps; ++i) {
+    c.pop_back();
+  }
+  return 2 * kEndsOps;
+}
+
+template <typename Container>
+size_t PushPopFront() {
+  Container c;
+  if constexpr (kHasFront<Container>) {
+    for (size_t i = 0; i < kEndsOps; ++i) {
+      c.push_front(i);
+    }
+    for (size_t i = 0; i < kEndsOps; ++i) {
+      c.pop_front();
+    }
+    return 2 * kEndsOps;
+  }
+  return 0;
+}
+
+template <typename Container>
+size_t RandomAccess() {
+  Container c(kAccessSize);
+  std::mt19937 g(17);
+  size_t sum = 0;
+  for (size_t i = 0; i < kAccessSize; ++i) {
+    sum += c[g() % kAccessSize];
+  }
+  sink = sum;
+  return kAccessSize;
+}
+
+template <typename Container>
+size_t Iteration() {
+  Container c(kAccessSize);
+  size_t sum = 0;
+  for (int round = 0; round < 10; ++round) {
+    for (const auto& x : c) {
+      sum += x;
+    }
+  }
+  sink = sum;
+  return 10 * kAccessSize;
+}
+
+template <typename Container>
+size_t MiddleInsertErase() {
+  Container c(kMiddleSize);
+  std::mt19937 g(17);
+  for (size_t i = 0; i < kMiddleOps; ++i) {
+    c.insert(c.begin() + g() % c.size(), c[0]);
+    c.erase(c.begin() + g() % c.size());
+  }
+  return 2 * kMiddleOps;
+}
+
+template <typename Container>
+size_t Copy() {
+  Container c(kCopySize);
+  for (int round = 0; round < 5; ++round) {
+    Container copy = c;
+    sink = copy.size();
+  }
+  return 5 * kCopySize;
+}
+
+template <typename Case>
+void Run(const char* container, const char* type, const char* name,
+         Case run_case) {
+  std::fflush(stdout);
+  pid_t child = fork();
+  if (child == 0) {
+    auto start = std::chrono::steady_clock::now();
+    size_t ops = run_case();
+    auto finish = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(finish - start).count();
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    if (ops == 0) {
+      std::printf("%-12s %-7s %-20s %12s %12s\n", container, type, name, "n/a",
+                  "n/a");
+    } else {
+      std::printf("%-12s %-7s %-20s %12.2f %12ld\n", container, type, name,
+                  ops / seconds / 1e6, usage.ru_maxrss);
+    }
+    std::fflush(stdout);
+    _exit(0);
+  }
+  waitpid(child, nullptr, 0);
+}
+
+template <typename Container>
+void RunAll(const char* container, const char* type) {
+  Run(container, type, "push/pop back", PushPopBack<Container>);
+  Run(container, type, "push/pop front", PushPopFront<Container>);
+  Run(container, type, "random access", RandomAccess<Container>);
+  Run(container, type, "iteration", Iteration<Container>);
+  Run(container, type, "middle insert/erase", MiddleInsertErase<Container>);
+  Run(container, type, "copy", Copy<Container>);
+}
+
+int main() {
+  std::printf("%-12s %-7s %-20s %12s %12s\n", "container", "type", "case",
+              "Mops/s", "peak RSS KB");
+  RunAll<Deque<size_t>>("Deque", "size_t");
+  RunAll<std::deque<size_t>>("std::deque", "size_t");
+  RunAll<std::vector<size_t>>("std::vector", "size_t");
+  RunAll<Deque<Heavy>>("Deque", "Heavy");
+  RunAll<std::deque<Heavy>>("std::deque", "Heavy");
+  RunAll<std::vector<Heavy>>("std::vector", "Heavy");
+}
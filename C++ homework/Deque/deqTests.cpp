@@ -1,17 +1,56 @@
 #include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <chrono>
+#include <cstdlib>
 #include <deque>
 #include <iostream>
+#include <new>
 #include <numeric>
 #include <random>
+#include <stdexcept>
+#include <thread>
 #include <type_traits>
 #include <unordered_set>
+#include <vector>
 
 #include "deque.h"
+#include "deque_algorithms.h"
+#include "snapshot_deque.h"
+#include "spill_deque.h"
+#include "spsc_deque.h"
 
 // template <typename T>
 // using Deque = std::deque<T>;
 
+std::atomic<size_t> new_called = 0;
+
+// Counts every allocation the tests make. All replaced forms go through one
+// pair of functions kept out of line: once std::free is inlined into a
+// caller that got its memory from operator new, GCC reports the pair as
+// mismatched even though the two replacements do match.
+[[gnu::noinline]] void* counted_malloc(size_t n) {
+  ++new_called;
+  if (void* ptr = std::malloc(n)) {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+
+[[gnu::noinline]] void counted_free(void* ptr) noexcept { std::free(ptr); }
+
+void* operator new(size_t n) { return counted_malloc(n); }
+
+void* operator new[](size_t n) { return counted_malloc(n); }
+
+void operator delete(void* ptr) noexcept { counted_free(ptr); }
+
+void operator delete(void* ptr, size_t) noexcept { counted_free(ptr); }
+
+void operator delete[](void* ptr) noexcept { counted_free(ptr); }
+
+void operator delete[](void* ptr, size_t) noexcept { counted_free(ptr); }
+
 namespace TestsByMesyarik {
 
 void test1() {
@@ -638,6 +677,448 @@ void testInsertAndErase() {
   //  assert(std::equal(d.begin(), d.end(), copy.begin()));
 }
 
+template <typename T, typename Make>
+void checkMidInsertErase(Make make) {
+  Deque<T> d;
+  std::deque<T> expected;
+  std::mt19937 g(2718);
+  for (int i = 0; i < 3000; ++i) {
+    size_t pos = expected.empty() ? 0 : g() % (expected.size() + 1);
+    switch (g() % 4) {
+      case 0:
+        d.insert(d.begin() + pos, make(i));
+        expected.insert(expected.begin() + pos, make(i));
+        break;
+      case 1: {
+        std::vector<T> range;
+        for (size_t k = 1 + g() % 70; k > 0; --k) {
+          range.push_back(make(i + k));
+        }
+        d.insert(d.begin() + pos, range.begin(), range.end());
+        expected.insert(expected.begin() + pos, range.begin(), range.end());
+        break;
+      }
+      case 2:
+        if (pos < expected.size()) {
+          d.erase(d.begin() + pos);
+          expected.erase(expected.begin() + pos);
+        }
+        break;
+      default: {
+        size_t count = std::min<size_t>(g() % 50, expected.size() - pos);
+        d.erase(d.begin() + pos, d.begin() + pos + count);
+        expected.erase(expected.begin() + pos, expected.begin() + pos + count);
+      }
+    }
+    assert(d.size() == expected.size());
+  }
+  assert(std::equal(d.begin(), d.end(), expected.begin()));
+}
+
+void testRangeInsertAndErase() {
+  checkMidInsertErase<int>([](int i) { return i; });
+  checkMidInsertErase<std::string>(
+      [](int i) { return std::string(20, 'a' + i % 26); });
+
+  Deque<int> d;
+  std::vector<int> values = {1, 2, 3, 4};
+  d.insert(d.end(), values.begin(), values.end());
+  d.insert(d.begin() + 2, values.begin(), values.begin());
+  d.erase(d.begin() + 1, d.begin() + 1);
+  assert(d.size() == 4 && d[0] == 1 && d[3] == 4);
+  d.erase(d.begin(), d.end());
+  assert(d.size() == 0);
+}
+
+void testBulkConstructionAndResize() {
+  std::vector<int> values(1000);
+  std::iota(values.begin(), values.end(), 0);
+  Deque<int> from_range(values.begin(), values.end());
+  assert(from_range.size() == 1000 &&
+         std::equal(from_range.begin(), from_range.end(), values.begin()));
+
+  std::deque<std::string> words(77, "word");
+  Deque<std::string> strings(words.begin(), words.end());
+  assert(strings.size() == 77 && strings[76] == "word");
+
+  from_range.pop_front();
+  Deque<int> copy = from_range;
+  assert(std::equal(copy.begin(), copy.end(), values.begin() + 1));
+
+  copy.assign(5, 7);
+  assert(copy.size() == 5 && copy[4] == 7);
+  copy.assign(values.begin(), values.begin() + 40);
+  assert(copy.size() == 40 && copy[39] == 39);
+
+  copy.resize(1000);
+  assert(copy.size() == 1000 && copy[39] == 39 && copy[999] == 0);
+  copy.resize(3);
+  assert(copy.size() == 3 && *(copy.end() - 1) == 2);
+  copy.resize(70, -1);
+  assert(copy.size() == 70 && copy[2] == 2 && copy[69] == -1);
+
+  strings.resize(10);
+  strings.resize(40, "tail");
+  assert(strings.size() == 40 && strings[9] == "word" && strings[10] == "tail");
+
+  int* first = &copy[0];
+  for (int i = 0; i < 5000; ++i) {
+    copy.push_front(i);
+    copy.push_back(i);
+  }
+  assert(*first == 0 && copy.size() == 10070);
+
+  for (int i = 0; i < 9000; ++i) {
+    copy.pop_front();
+  }
+  copy.shrink_to_fit();
+  assert(copy.size() == 1070 && copy[1069] == 4999);
+  copy.push_front(1);
+  copy.push_back(2);
+  assert(copy.size() == 1072 && copy[0] == 1 && copy[1071] == 2);
+
+  copy.clear();
+  assert(copy.size() == 0 && copy.begin() == copy.end());
+  copy.shrink_to_fit();
+  copy.push_back(3);
+  assert(copy.size() == 1 && copy[0] == 3);
+}
+
+void testSmallInlineDeque() {
+  Deque<int> d;
+  std::deque<int> expected;
+  size_t deque_new_called = 0;
+  auto on_both = [&](auto operation) {
+    size_t before = new_called;
+    operation(d);
+    deque_new_called += new_called - before;
+    operation(expected);
+  };
+  for (int i = 0; i < 10'000; ++i) {
+    if (i % 3 == 0) {
+      on_both([i](auto& container) { container.push_front(i); });
+    } else {
+      on_both([i](auto& container) { container.push_back(i); });
+    }
+    if (d.size() > 12) {
+      on_both([](auto& container) { container.pop_front(); });
+    }
+    if (i % 7 == 0) {
+      on_both([i](auto& container) {
+        container.insert(container.begin() + container.size() / 2, i);
+        container.pop_back();
+      });
+    }
+  }
+  assert(deque_new_called == 0);
+  assert(std::equal(d.begin(), d.end(), expected.begin(), expected.end()));
+
+  size_t before_copies = new_called;
+  Deque<int> copy = d;
+  copy = d;
+  d = copy;
+  assert(new_called == before_copies);
+  assert(std::equal(d.begin(), d.end(), copy.begin(), copy.end()));
+
+  for (int i = 0; i < 1000; ++i) {
+    d.push_back(i);
+    expected.push_back(i);
+  }
+  for (int i = 0; i < 1005; ++i) {
+    d.pop_front();
+    expected.pop_front();
+  }
+  d.shrink_to_fit();
+  for (int i = 0; i < 100; ++i) {
+    d.push_front(-i);
+    expected.push_front(-i);
+  }
+  assert(std::equal(d.begin(), d.end(), expected.begin(), expected.end()));
+
+  Deque<std::string> strings;
+  for (int i = 0; i < 100; ++i) {
+    strings.push_front(std::to_string(i));
+    if (strings.size() > 10) {
+      strings.pop_back();
+    }
+  }
+  assert(strings.size() == 10 && strings[0] == "99" && strings[9] == "90");
+}
+
+// Owns its value on the heap, so reading a moved-from or destroyed Boxed is
+// caught by the sanitizers instead of going unnoticed.
+struct Boxed {
+  int* value;
+
+  Boxed(int value) : value(new int(value)) {}
+  Boxed(const Boxed& another) : value(new int(*another.value)) {}
+  Boxed(Boxed&& another) noexcept : value(another.value) {
+    another.value = nullptr;
+  }
+  Boxed& operator=(Boxed another) noexcept {
+    std::swap(value, another.value);
+    return *this;
+  }
+  ~Boxed() { delete value; }
+};
+
+void testInlineAliasing() {
+  static_assert(sizeof(Boxed) == 8);
+  auto values = [](const Deque<Boxed>& d) {
+    std::vector<int> result;
+    for (const Boxed& boxed : d) {
+      result.push_back(*boxed.value);
+    }
+    return result;
+  };
+
+  // The inline chunk has no room at the front, so it slides first.
+  Deque<Boxed> front;
+  front.push_back(7);
+  front.push_front(front[0]);
+  assert(values(front) == std::vector<int>({7, 7}));
+
+  // Same at the back, with the last element in the last cell.
+  Deque<Boxed> back;
+  for (int i = 0; i < 31; ++i) {
+    back.push_back(i);
+  }
+  for (int i = 0; i < 29; ++i) {
+    back.pop_front();
+  }
+  back.push_back(back[back.size() - 1]);
+  assert(values(back) == std::vector<int>({29, 30, 30}));
+
+  Deque<Boxed> middle;
+  for (int i = 1; i <= 3; ++i) {
+    middle.push_back(i);
+  }
+  middle.insert(middle.begin() + 1, 42);
+  assert(values(middle) == std::vector<int>({1, 42, 2, 3}));
+}
+
+void testParallelAlgorithms() {
+  ThreadPool pool(4);
+  Deque<int> d;
+  for (int i = 0; i < 100'000; ++i) {
+    d.push_front(i);
+  }
+  d.pop_front();
+
+  parallel_for_each(d, [](int& x) { x *= 3; }, pool);
+  assert(d[0] == 3 * 99'998 && d[99'998] == 0);
+
+  Deque<long long> squares;
+  parallel_transform(
+      d, squares, [](int x) { return 1LL * x * x; }, pool);
+  assert(squares.size() == d.size() && squares[1] == 9LL * 99'997 * 99'997);
+
+  // The destination's chunks start at a different offset than the source's.
+  Deque<long long> shifted;
+  for (int i = 0; i < 5; ++i) {
+    shifted.push_front(-1);
+  }
+  parallel_transform(
+      d, shifted, [](int x) { return 1LL * x; }, pool);
+  assert(std::equal(d.begin(), d.end(), shifted.begin(), shifted.end()));
+
+  long long sum = parallel_reduce(d, 0LL, std::plus<>(), pool);
+  assert(sum == 3LL * 99'998 * 99'999 / 2);
+
+  std::mt19937 g(31415);
+  std::shuffle(d.begin(), d.end(), g);
+  parallel_sort(d, std::less<>(), pool);
+  assert(std::is_sorted(d.begin(), d.end()) && d[1] == 3);
+
+  Deque<std::string> strings;
+  for (int i = 0; i < 1000; ++i) {
+    strings.push_back(std::to_string(i * 7919 % 1000));
+  }
+  parallel_sort(strings, std::greater<>());
+  assert(std::is_sorted(strings.rbegin(), strings.rend()));
+
+  // The exception is only rethrown once every other part has finished.
+  std::atomic<bool> last_done = false;
+  try {
+    parallel_for_each(
+        d,
+        [&](int& x) {
+          if (&x == &d[0]) {
+            throw std::runtime_error("first");
+          }
+          if (&x == &d[d.size() - 1]) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            last_done = true;
+          }
+        },
+        pool);
+    assert(false);
+  } catch (const std::runtime_error&) {
+    assert(last_done);
+  }
+
+  Deque<int> empty;
+  parallel_sort(empty);
+  parallel_for_each(empty, [](int&) { assert(false); });
+  assert(parallel_reduce(empty, 5) == 5);
+}
+
+void testSpscDeque() {
+  SpscDeque<std::string> queue;
+  std::string value;
+  assert(queue.empty() && !queue.try_pop_front(value));
+
+  const int count = 200'000;
+  std::thread producer([&queue] {
+    for (int i = 0; i < count; ++i) {
+      queue.push_back(std::to_string(i));
+    }
+  });
+  for (int i = 0; i < count; ++i) {
+    while (!queue.try_pop_front(value)) {
+      std::this_thread::yield();
+    }
+    assert(value == std::to_string(i));
+  }
+  producer.join();
+  assert(queue.empty());
+
+  SpscDeque<std::string> leftovers;
+  for (int i = 0; i < 100; ++i) {
+    leftovers.push_back(std::string(50, 'x'));
+  }
+}
+
+struct Copyable {
+  static inline size_t copies = 0;
+  int value;
+  Copyable(int value) : value(value) {}
+  Copyable(const Copyable& another) : value(another.value) { ++copies; }
+};
+
+void testSnapshotDeque() {
+  SnapshotDeque<Copyable> d;
+  std::deque<int> expected;
+  for (int i = 0; i < 1000; ++i) {
+    d.push_back(i);
+    d.push_front(-i);
+    expected.push_back(i);
+    expected.push_front(-i);
+  }
+  Copyable::copies = 0;
+  SnapshotDeque<Copyable> snapshot = d.snapshot();
+  assert(Copyable::copies == 0 && snapshot.size() == expected.size());
+
+  d[1000].value = 42;
+  assert(Copyable::copies <= 32);
+  assert(snapshot[1000].value == expected[1000]);
+  std::mt19937 g(32);
+  std::deque<int> changed = expected;
+  changed[1000] = 42;
+  for (int i = 0; i < 5000; ++i) {
+    switch (g() % 4) {
+      case 0:
+        d.push_back(i);
+        changed.push_back(i);
+        break;
+      case 1:
+        d.push_front(i);
+        changed.push_front(i);
+        break;
+      case 2:
+        d.pop_back();
+        changed.pop_back();
+        break;
+      default:
+        d.pop_front();
+        changed.pop_front();
+    }
+  }
+  assert(std::equal(d.begin(), d.end(), changed.begin(), changed.end(),
+                    [](const Copyable& x, int y) { return x.value == y; }));
+  assert(std::equal(snapshot.begin(), snapshot.end(), expected.begin(),
+                    expected.end(),
+                    [](const Copyable& x, int y) { return x.value == y; }));
+
+  SnapshotDeque<Copyable> frozen = d.snapshot();
+  std::thread reader([frozen] {
+    assert(frozen.size() > 0);
+    long long sum = 0;
+    for (const Copyable& x : frozen) {
+      sum += x.value;
+    }
+    (void)sum;
+  });
+  for (size_t i = 0; i < d.size(); ++i) {
+    d[i].value = -1;
+  }
+  reader.join();
+
+  SnapshotDeque<std::string> strings;
+  for (int i = 0; i < 100; ++i) {
+    strings.push_back(std::string(40, 'a' + i % 26));
+  }
+  {
+    SnapshotDeque<std::string> copy = strings;
+    strings.pop_front();
+    strings.pop_back();
+    copy = strings;
+  }
+  strings.push_front("front");
+  strings.push_back("back");
+  assert(strings.size() == 100 && strings[0] == "front");
+  assert(strings.at(99) == "back" && strings[1] == std::string(40, 'b'));
+  while (strings.size() > 0) {
+    strings.pop_back();
+  }
+}
+
+void testSpillDeque() {
+  struct Record {
+    size_t id;
+    double weight;
+  };
+
+  SpillDeque<Record> d(4);
+  std::deque<size_t> expected;
+  const size_t chunk = (1 << 16) / sizeof(Record);
+  for (size_t i = 0; i < 20 * chunk; ++i) {
+    d.push_back({i, 0.5});
+    expected.push_back(i);
+  }
+  assert(d.spilled_chunks() == 16);
+  assert(d[10 * chunk + 7].id == expected[10 * chunk + 7]);
+
+  std::mt19937 g(33);
+  for (size_t i = 0; i < 40 * chunk; ++i) {
+    switch (g() % 4) {
+      case 0:
+        d.push_back({i, 1.5});
+        expected.push_back(i);
+        break;
+      case 1:
+        d.push_front({i, 2.5});
+        expected.push_front(i);
+        break;
+      case 2:
+        d.pop_back();
+        expected.pop_back();
+        break;
+      default:
+        d.pop_front();
+        expected.pop_front();
+    }
+    assert(d.front().id == expected.front());
+    assert(d.back().id == expected.back());
+  }
+  while (!expected.empty()) {
+    assert(d.front().id == expected.front());
+    d.pop_front();
+    expected.pop_front();
+  }
+  assert(d.empty() && d.spilled_chunks() == 0);
+}
+
 void testExceptions() {
   try {
     Deque<Counted<17>> d(100);
@@ -746,6 +1227,14 @@ int main() {
     TestsByUnrealf1::testIteratorsAlgorithms();
     TestsByUnrealf1::testPushAndPop();
     TestsByUnrealf1::testInsertAndErase();
+    TestsByUnrealf1::testRangeInsertAndErase();
+    TestsByUnrealf1::testBulkConstructionAndResize();
+    TestsByUnrealf1::testSmallInlineDeque();
+    TestsByUnrealf1::testInlineAliasing();
+    TestsByUnrealf1::testParallelAlgorithms();
+    TestsByUnrealf1::testSpscDeque();
+    TestsByUnrealf1::testSnapshotDeque();
+    TestsByUnrealf1::testSpillDeque();
   TestsByUnrealf1::testExceptions();
 //   TestsByUnrealf1::testStrongGuarantee();
 
@@ -1,35 +1,107 @@
+#pragma once
+
+#include <algorithm>
+#include <cstring>
 #include <iostream>
+#include <iterator>
+#include <memory>
+#include <span>
+#include <type_traits>
+
 template <typename T>
 class Deque {
  private:
   static const size_t chunk_size_ = 32;
+  // Deques of small elements keep one chunk and a one-row map inside the
+  // object, so short queues never touch the heap.
+  static const bool inline_enabled_ = chunk_size_ * sizeof(T) <= 256;
   template <typename U>
   struct CellIndex;
+
+  struct InlineStorage {
+    T* map[1] = {nullptr};
+    alignas(T) char chunk[chunk_size_ * sizeof(T)];
+    bool chunk_used = false;
+  };
+  struct NoInlineStorage {};
+
   T** arr_ = nullptr;
   size_t sz_ = 0;
   size_t cap_ = 0;
   CellIndex<size_t> b_pos_ = {0, 0};
   CellIndex<size_t> e_pos_ = {0, 0};
+  [[no_unique_address]] std::conditional_t<inline_enabled_, InlineStorage,
+                                           NoInlineStorage> inline_;
   void swap(Deque<T>& another);
+  T** inline_map();
+  T* inline_chunk();
+  bool reserve_inline(size_t count, bool at_front);
+  bool slides_inline(size_t count, bool at_front) const;
+  void recentre_inline(size_t new_b_col);
+  void evict_inline();
   CellIndex<size_t> get_position_by_index(size_t index) const;
-  void swap_with_unitianalized_deque(size_t new_size);
+  void allocate_chunk(size_t row);
+  void free_chunk(size_t row);
+  void reallocate_map(size_t rows_to_add, bool at_front);
+  void reserve_front(size_t count);
+  void reserve_back(size_t count);
+  template <typename... Args>
+  void emplace_front_reserved(Args&&... args);
+  template <typename... Args>
+  void emplace_back_reserved(Args&&... args);
+  template <typename Construct>
+  void construct_back(size_t count, Construct construct);
+  void destroy_back(size_t count);
+  void shift_left(size_t from, size_t to, size_t shift);
+  void shift_right(size_t from, size_t to, size_t shift);
+  template <typename Source>
+  void open_gap(size_t index, size_t count, const Source& placeholder);
 
  public:
   Deque() : arr_(nullptr), sz_(0), cap_(0){};
   Deque(const Deque<T>& another);
   Deque(size_t new_size);
-  void init();
   void clear_init();
   void clear_block();
   size_t size() const;
   T& operator[](size_t index);
   const T& operator[](size_t index) const;
   Deque(size_t new_size, const T& value);
+
+  template <typename ForwardIt,
+            typename = std::enable_if_t<std::is_base_of_v<
+                std::forward_iterator_tag,
+                typename std::iterator_traits<ForwardIt>::iterator_category>>>
+  Deque(ForwardIt first, ForwardIt last);
+
   Deque<T>& operator=(const Deque<T>& another);
+  void assign(size_t new_size, const T& value);
+
+  template <typename ForwardIt,
+            typename = std::enable_if_t<std::is_base_of_v<
+                std::forward_iterator_tag,
+                typename std::iterator_traits<ForwardIt>::iterator_category>>>
+  void assign(ForwardIt first, ForwardIt last);
+
+  void resize(size_t new_size);
+  void resize(size_t new_size, const T& value);
+  void clear();
+  void shrink_to_fit();
+
+  // Elements from index up to the end of their chunk, which are contiguous in
+  // memory. Lets algorithms run over raw pointers chunk by chunk.
+  std::span<T> segment_from(size_t index);
+  std::span<const T> segment_from(size_t index) const;
   T& at(size_t index);
   const T& at(size_t index) const;
-  void push_back(const T& value);
-  void push_front(const T& value);
+  template <typename... Args>
+  void emplace_back(Args&&... args);
+  template <typename... Args>
+  void emplace_front(Args&&... args);
+  void push_back(const T& value) { emplace_back(value); }
+  void push_back(T&& value) { emplace_back(std::move(value)); }
+  void push_front(const T& value) { emplace_front(value); }
+  void push_front(T&& value) { emplace_front(std::move(value)); }
   void pop_back();
   void pop_front();
   template <bool IsConst>
@@ -101,9 +173,8 @@ class Deque {
       if (shift > 0) {
         if (shift > static_cast<int>(iter_pos_.col)) {
           shift -= iter_pos_.col;
-          iter_pos_.row -= (shift / chunk_size_ + 1);
-          iter_pos_.col = 0;
-          iter_pos_.col = chunk_size_ - (shift % chunk_size_);
+          iter_pos_.row -= (shift + chunk_size_ - 1) / chunk_size_;
+          iter_pos_.col = (chunk_size_ - shift % chunk_size_) % chunk_size_;
         } else {
           iter_pos_.row -= shift / chunk_size_;
           iter_pos_.col -= (shift % chunk_size_);
@@ -230,17 +301,44 @@ class Deque {
 
   void insert(const iterator& iter, const T& value) {
     T helper = value;
-    for (iterator it = iter; it != end(); ++it) {
-      std::swap(helper, *it);
+    size_t index = iter - begin();
+    open_gap(index, 1, helper);
+    (*this)[index] = std::move(helper);
+  }
+
+  template <typename ForwardIt,
+            typename = std::enable_if_t<std::is_base_of_v<
+                std::forward_iterator_tag,
+                typename std::iterator_traits<ForwardIt>::iterator_category>>>
+  void insert(const iterator& iter, ForwardIt first, ForwardIt last) {
+    size_t count = std::distance(first, last);
+    if (count == 0) {
+      return;
     }
-    push_back(helper);
+    size_t index = iter - begin();
+    open_gap(index, count, *first);
+    std::copy(first, last, begin() + index);
   }
 
-  void erase(const iterator& iter) {
-    for (iterator it = iter; it != end(); ++it) {
-      std::swap(*it, *(it + 1));
+  void erase(const iterator& iter) { erase(iter, iter + 1); }
+
+  void erase(const iterator& first, const iterator& last) {
+    size_t index = first - begin();
+    size_t count = last - first;
+    if (count == 0) {
+      return;
+    }
+    if (index < sz_ - index - count) {
+      shift_right(0, index, count);
+      for (size_t i = 0; i < count; ++i) {
+        pop_front();
+      }
+    } else {
+      shift_left(index + count, sz_, count);
+      for (size_t i = 0; i < count; ++i) {
+        pop_back();
+      }
     }
-    pop_back();
   }
 
   ~Deque();
@@ -257,6 +355,9 @@ void Deque<T>::pop_front() {
   begin()->~T();
   --sz_;
   ++b_pos_;
+  if (b_pos_.col == 0) {
+    free_chunk(b_pos_.row - 1);
+  }
 }
 
 template <typename T>
@@ -264,59 +365,75 @@ void Deque<T>::pop_back() {
   (end() - 1)->~T();
   --e_pos_;
   --sz_;
+  if (e_pos_.col == 0) {
+    free_chunk(e_pos_.row);
+  }
 }
 
+// Sliding the inline chunk moves the elements args may refer to, as in
+// push_front(d[0]), so in that case the new element is built first.
 template <typename T>
-void Deque<T>::push_front(const T& value) {
-  if (sz_ == 0 || (b_pos_.col == 0 && b_pos_.row == 0)) {
-    ++sz_;
-    Deque<T> new_dq;
-    new_dq.swap_with_unitianalized_deque(sz_);
-    CellIndex<size_t> new_end_index = new_dq.get_position_by_index(0);
-    new (new_dq.arr_[new_end_index.row] + new_end_index.col) T(value);
-    for (size_t i = 1; i < sz_; ++i) {
-      CellIndex<size_t> new_index = new_dq.get_position_by_index(i);
-      new (new_dq.arr_[new_index.row] + new_index.col) T((*this)[i - 1]);
-    }
-    *this = new_dq;
-  } else {
-    try {
-      --b_pos_;
-      new (arr_[b_pos_.row] + b_pos_.col) T(value);
-      ++sz_;
-    } catch (...) {
-      ++b_pos_;
-      throw;
-    }
-  };
+template <typename... Args>
+void Deque<T>::emplace_front(Args&&... args) {
+  if (slides_inline(1, true)) {
+    T value(std::forward<Args>(args)...);
+    reserve_front(1);
+    emplace_front_reserved(std::move(value));
+    return;
+  }
+  reserve_front(1);
+  emplace_front_reserved(std::forward<Args>(args)...);
 }
+
 template <typename T>
-void Deque<T>::push_back(const T& value) {
-  ++e_pos_;
-  ++sz_;
-  if (e_pos_.row < cap_ && sz_ > 1) {
-    try {
-      --e_pos_;
-      new (arr_[e_pos_.row] + e_pos_.col) T(value);
-      ++e_pos_;
-    } catch (...) {
-      --sz_;
-      throw;
+template <typename... Args>
+void Deque<T>::emplace_back(Args&&... args) {
+  if (slides_inline(1, false)) {
+    T value(std::forward<Args>(args)...);
+    reserve_back(1);
+    emplace_back_reserved(std::move(value));
+    return;
+  }
+  reserve_back(1);
+  emplace_back_reserved(std::forward<Args>(args)...);
+}
+
+// Builds one element before the first one, in a cell reserve_front has made.
+template <typename T>
+template <typename... Args>
+void Deque<T>::emplace_front_reserved(Args&&... args) {
+  CellIndex<size_t> new_b_pos = b_pos_;
+  --new_b_pos;
+  bool fresh_chunk = (arr_[new_b_pos.row] == nullptr);
+  allocate_chunk(new_b_pos.row);
+  try {
+    new (arr_[new_b_pos.row] + new_b_pos.col) T(std::forward<Args>(args)...);
+  } catch (...) {
+    if (fresh_chunk) {
+      free_chunk(new_b_pos.row);
     }
-  } else {
-    --e_pos_;
-    Deque<T> new_dq;
-    new_dq.swap_with_unitianalized_deque(sz_);
-    CellIndex<size_t> new_end_index = new_dq.get_position_by_index(sz_ - 1);
-    --new_dq.e_pos_;
-    new (new_dq.arr_[new_end_index.row] + new_end_index.col) T(value);
-    ++new_dq.e_pos_;
-    for (size_t i = 0; i < sz_ - 1; ++i) {
-      CellIndex<size_t> new_index = new_dq.get_position_by_index(i);
-      new (new_dq.arr_[new_index.row] + new_index.col) T((*this)[i]);
+    throw;
+  }
+  b_pos_ = new_b_pos;
+  ++sz_;
+}
+
+// Builds one element after the last one, in a cell reserve_back has made.
+template <typename T>
+template <typename... Args>
+void Deque<T>::emplace_back_reserved(Args&&... args) {
+  bool fresh_chunk = (arr_[e_pos_.row] == nullptr);
+  allocate_chunk(e_pos_.row);
+  try {
+    new (arr_[e_pos_.row] + e_pos_.col) T(std::forward<Args>(args)...);
+  } catch (...) {
+    if (fresh_chunk) {
+      free_chunk(e_pos_.row);
     }
-    *this = new_dq;
+    throw;
   }
+  ++e_pos_;
+  ++sz_;
 }
 
 template <typename T>
@@ -342,6 +459,14 @@ Deque<T>& Deque<T>::operator=(const Deque<T>& another) {
   if (&another == this) {
     return *this;
   }
+  // swap has to move inline contents to the heap, so a small copy is
+  // assigned in place instead. Only for T whose copy cannot throw, which
+  // keeps the strong guarantee of copy-and-swap.
+  if (inline_enabled_ && std::is_nothrow_copy_constructible_v<T> &&
+      another.sz_ < chunk_size_ && (arr_ == nullptr || arr_ == inline_map())) {
+    assign(another.begin(), another.end());
+    return *this;
+  }
   Deque<T> copy(another);
   swap(copy);
   return *this;
@@ -354,6 +479,8 @@ size_t Deque<T>::size() const {
 
 template <typename T>
 void Deque<T>::swap(Deque<T>& another) {
+  evict_inline();
+  another.evict_inline();
   std::swap(arr_, another.arr_);
   std::swap(sz_, another.sz_);
   std::swap(cap_, another.cap_);
@@ -363,38 +490,34 @@ void Deque<T>::swap(Deque<T>& another) {
 
 template <typename T>
 Deque<T>::Deque(const Deque<T>& another) {
-  sz_ = another.sz_;
-  cap_ = another.cap_;
-  b_pos_ = another.b_pos_;
-  e_pos_ = another.e_pos_;
-  arr_ = new T*[cap_];
-  for (size_t i = 0; i < cap_; ++i) {
-    arr_[i] = reinterpret_cast<T*>(new char[chunk_size_ * sizeof(T)]);
-  }
-  CellIndex<size_t> copy_b_pos = b_pos_;
-  while (copy_b_pos != e_pos_) {
-    try {
-      new (arr_[copy_b_pos.row] + copy_b_pos.col)
-          T(another.arr_[copy_b_pos.row][copy_b_pos.col]);
-      ++copy_b_pos;
-    } catch (...) {
-      CellIndex<size_t> new_b_pos = b_pos_;
-      while (new_b_pos != copy_b_pos) {
-        (arr_[new_b_pos.row] + new_b_pos.col)->~T();
-        ++new_b_pos;
-      }
-      throw;
-    }
-  }
-}
-
-template <typename T>
-void Deque<T>::init() {
+  // Keeping the column offset of another makes every chunk segment of the
+  // copy line up with a contiguous run of the source.
+  b_pos_.col = e_pos_.col = another.b_pos_.col;
   try {
-    for (size_t i = 0; i < cap_; ++i) {
-      arr_[i] = reinterpret_cast<T*>(new char[chunk_size_ * sizeof(T)]);
-    }
+    construct_back(another.sz_, [this, &another](T* destination,
+                                                 size_t count) {
+      size_t copied = 0;
+      try {
+        while (copied < count) {
+          std::span<const T> source = another.segment_from(sz_ + copied);
+          size_t segment = std::min(count - copied, source.size());
+          if constexpr (std::is_trivially_copyable_v<T>) {
+            std::memcpy(destination + copied, source.data(),
+                        segment * sizeof(T));
+          } else {
+            std::uninitialized_copy_n(source.data(), segment,
+                                      destination + copied);
+          }
+          copied += segment;
+        }
+      } catch (...) {
+        std::destroy_n(destination, copied);
+        throw;
+      }
+    });
   } catch (...) {
+    clear_init();
+    clear_block();
     throw;
   }
 }
@@ -404,11 +527,9 @@ void Deque<T>::clear_init() {
   if (arr_ == nullptr || sz_ == 0) {
     return;
   }
-  for (iterator it = begin(); it != end(); ++it) {
-    try {
+  if constexpr (!std::is_trivially_destructible_v<T>) {
+    for (iterator it = begin(); it != end(); ++it) {
       it->~T();
-    } catch (...) {
-      throw "zxc";
     }
   }
 }
@@ -418,52 +539,365 @@ void Deque<T>::clear_block() {
   if (arr_ == nullptr) {
     return;
   }
-  delete[] arr_;
+  for (size_t i = 0; i < cap_; ++i) {
+    free_chunk(i);
+  }
+  if (arr_ != inline_map()) {
+    delete[] arr_;
+  }
 }
 
 template <typename T>
-void Deque<T>::swap_with_unitianalized_deque(size_t new_size) {
-  Deque<T> new_dq;
-  new_dq.sz_ = new_size;
-  new_dq.cap_ = 2 * (new_size / chunk_size_ + 1);
-  new_dq.b_pos_ = {new_dq.cap_ / 2 - (new_dq.sz_ / 2 / chunk_size_ + 1),
-                   chunk_size_ - (new_dq.sz_ / 2 % chunk_size_ + 1)};
-  new_dq.e_pos_ = new_dq.b_pos_;
-  try {
-    new_dq.arr_ = new T*[new_dq.cap_];
-  } catch (...) {
-    delete[] new_dq.arr_;
-    throw;
+T** Deque<T>::inline_map() {
+  if constexpr (inline_enabled_) {
+    return inline_.map;
   }
-  try {
-    new_dq.init();
-  } catch (...) {
-    new_dq.clear_block();
-    throw;
+  return nullptr;
+}
+
+template <typename T>
+T* Deque<T>::inline_chunk() {
+  if constexpr (inline_enabled_) {
+    return reinterpret_cast<T*>(inline_.chunk);
   }
+  return nullptr;
+}
 
-  for (size_t i = 0; i < new_dq.size(); ++i) {
-    ++new_dq.e_pos_;
+template <typename T>
+void Deque<T>::allocate_chunk(size_t row) {
+  if (arr_[row] != nullptr) {
+    return;
+  }
+  if constexpr (inline_enabled_) {
+    if (!inline_.chunk_used) {
+      inline_.chunk_used = true;
+      arr_[row] = inline_chunk();
+      return;
+    }
   }
+  arr_[row] = reinterpret_cast<T*>(new char[chunk_size_ * sizeof(T)]);
+}
 
-  new_dq.swap(*this);
+template <typename T>
+void Deque<T>::free_chunk(size_t row) {
+  if (arr_[row] != nullptr && arr_[row] == inline_chunk()) {
+    if constexpr (inline_enabled_) {
+      inline_.chunk_used = false;
+    }
+  } else {
+    delete[] reinterpret_cast<char*>(arr_[row]);
+  }
+  arr_[row] = nullptr;
 }
 
+// While the deque fits into the inline chunk (one cell is kept free for
+// e_pos_) it stays on the inline map, sliding its elements back to the middle
+// of the chunk when one end runs out of room. That is how a ring buffer would
+// behave, but keeps positions linear for the iterators. Sliding moves
+// elements, so it is only done for small deques of nothrow-movable T;
+// otherwise the map spills to the heap and the inline chunk stays one of its
+// rows. References into a deque that is still inline are therefore not kept
+// by push_front and push_back; they are once it has spilled.
 template <typename T>
-Deque<T>::Deque(size_t new_size) {
-  swap_with_unitianalized_deque(new_size);
-  for (iterator it = begin(); it != end(); ++it) {
+bool Deque<T>::reserve_inline(size_t count, bool at_front) {
+  if constexpr (!inline_enabled_) {
+    return false;
+  }
+  if (arr_ != nullptr && arr_ != inline_map()) {
+    return false;
+  }
+  if (sz_ + count >= chunk_size_) {
+    return false;
+  }
+  if (arr_ == nullptr) {
+    arr_ = inline_map();
+    arr_[0] = nullptr;
+    cap_ = 1;
+    b_pos_.row = e_pos_.row = 0;
+  }
+  if (at_front ? b_pos_.col >= count : e_pos_.col + count < chunk_size_) {
+    return true;
+  }
+  if (sz_ > chunk_size_ / 2 || !std::is_nothrow_move_constructible_v<T>) {
+    return false;
+  }
+  size_t margin = (chunk_size_ - 1 - sz_ - count) / 2;
+  recentre_inline(at_front ? count + margin : margin);
+  return true;
+}
+
+template <typename T>
+bool Deque<T>::slides_inline(size_t count, bool at_front) const {
+  if constexpr (!inline_enabled_) {
+    return false;
+  } else {
+    return arr_ != nullptr && arr_ == inline_.map && sz_ + count < chunk_size_ &&
+           !(at_front ? b_pos_.col >= count
+                      : e_pos_.col + count < chunk_size_) &&
+           sz_ <= chunk_size_ / 2 && std::is_nothrow_move_constructible_v<T>;
+  }
+}
+
+template <typename T>
+void Deque<T>::recentre_inline(size_t new_b_col) {
+  if (sz_ > 0) {
+    T* chunk = arr_[0];
+    if constexpr (std::is_trivially_copyable_v<T>) {
+      std::memmove(chunk + new_b_col, chunk + b_pos_.col, sz_ * sizeof(T));
+    } else if (new_b_col < b_pos_.col) {
+      for (size_t i = 0; i < sz_; ++i) {
+        new (chunk + new_b_col + i) T(std::move(chunk[b_pos_.col + i]));
+        chunk[b_pos_.col + i].~T();
+      }
+    } else {
+      for (size_t i = sz_; i > 0; --i) {
+        new (chunk + new_b_col + i - 1) T(std::move(chunk[b_pos_.col + i - 1]));
+        chunk[b_pos_.col + i - 1].~T();
+      }
+    }
+  }
+  b_pos_.col = new_b_col;
+  e_pos_.col = new_b_col + sz_;
+}
+
+// Moves everything out of the inline storage so that arr_ and its chunks can
+// change owner, as swap does.
+template <typename T>
+void Deque<T>::evict_inline() {
+  if constexpr (inline_enabled_) {
+    bool inline_arr = (arr_ == inline_map());
+    if (!inline_.chunk_used && !inline_arr) {
+      return;
+    }
+    T** old_arr = arr_;
+    if (inline_arr) {
+      arr_ = new T*[1]{inline_.map[0]};
+    }
+    if (inline_.chunk_used) {
+      size_t row = b_pos_.row;
+      while (arr_[row] != inline_chunk()) {
+        ++row;
+      }
+      size_t first = (row == b_pos_.row ? b_pos_.col : 0);
+      size_t last = (row == e_pos_.row ? e_pos_.col : chunk_size_);
+      T* chunk = nullptr;
+      try {
+        chunk = reinterpret_cast<T*>(new char[chunk_size_ * sizeof(T)]);
+        std::uninitialized_move(inline_chunk() + first, inline_chunk() + last,
+                                chunk + first);
+      } catch (...) {
+        delete[] reinterpret_cast<char*>(chunk);
+        if (inline_arr) {
+          delete[] arr_;
+          arr_ = old_arr;
+        }
+        throw;
+      }
+      std::destroy(inline_chunk() + first, inline_chunk() + last);
+      arr_[row] = chunk;
+      inline_.chunk_used = false;
+    }
+  }
+}
+
+// Only the map of chunk pointers is reallocated, so references to elements
+// stay valid. If the map is mostly unused the live rows are just recentred.
+template <typename T>
+void Deque<T>::reallocate_map(size_t rows_to_add, bool at_front) {
+  size_t used_rows = (arr_ == nullptr ? 1 : e_pos_.row - b_pos_.row + 1);
+  size_t new_used_rows = used_rows + rows_to_add;
+  size_t new_cap = cap_;
+  if (cap_ <= 2 * new_used_rows) {
+    new_cap = cap_ + std::max(cap_, rows_to_add) + 2;
+  }
+  T** new_arr = new T*[new_cap]();
+  size_t new_b_row =
+      (new_cap - new_used_rows) / 2 + (at_front ? rows_to_add : 0);
+  if (arr_ != nullptr) {
+    std::copy(arr_ + b_pos_.row, arr_ + e_pos_.row + 1, new_arr + new_b_row);
+    if (arr_ != inline_map()) {
+      delete[] arr_;
+    }
+  }
+  arr_ = new_arr;
+  cap_ = new_cap;
+  e_pos_.row = new_b_row + (e_pos_.row - b_pos_.row);
+  b_pos_.row = new_b_row;
+}
+
+template <typename T>
+void Deque<T>::reserve_front(size_t count) {
+  if (arr_ == nullptr && sz_ == 0) {
+    b_pos_.col = e_pos_.col = chunk_size_ / 2;
+  }
+  if (reserve_inline(count, true)) {
+    return;
+  }
+  size_t free_cells = b_pos_.row * chunk_size_ + b_pos_.col;
+  if (arr_ == nullptr || free_cells < count) {
+    reallocate_map(
+        (count - std::min(count, b_pos_.col) + chunk_size_ - 1) / chunk_size_,
+        true);
+  }
+}
+
+template <typename T>
+void Deque<T>::reserve_back(size_t count) {
+  if (reserve_inline(count, false)) {
+    return;
+  }
+  size_t rows_to_add = (e_pos_.col + count) / chunk_size_;
+  if (arr_ == nullptr || e_pos_.row + rows_to_add >= cap_) {
+    reallocate_map(rows_to_add, false);
+  }
+}
+
+// Constructs count elements after the last one, a whole chunk segment per
+// construct(destination, n) call. construct must leave nothing behind when it
+// throws, as the std::uninitialized_* algorithms do.
+template <typename T>
+template <typename Construct>
+void Deque<T>::construct_back(size_t count, Construct construct) {
+  reserve_back(count);
+  while (count > 0) {
+    size_t segment = std::min(count, chunk_size_ - e_pos_.col);
+    bool fresh_chunk = (arr_[e_pos_.row] == nullptr);
+    allocate_chunk(e_pos_.row);
     try {
-      new (&*it) T();
+      construct(arr_[e_pos_.row] + e_pos_.col, segment);
     } catch (...) {
-      for (iterator remove_iter = begin(); remove_iter != it; ++remove_iter) {
-        remove_iter->~T();
+      if (fresh_chunk) {
+        free_chunk(e_pos_.row);
       }
       throw;
     }
+    sz_ += segment;
+    count -= segment;
+    e_pos_.col += segment;
+    if (e_pos_.col == chunk_size_) {
+      e_pos_.col = 0;
+      ++e_pos_.row;
+    }
+  }
+}
+
+template <typename T>
+void Deque<T>::destroy_back(size_t count) {
+  if constexpr (!std::is_trivially_destructible_v<T>) {
+    for (iterator it = end() - count; it != end(); ++it) {
+      it->~T();
+    }
+  }
+  CellIndex<size_t> new_e_pos = get_position_by_index(sz_ - count);
+  size_t first_free_row = new_e_pos.row + (new_e_pos.col == 0 ? 0 : 1);
+  for (size_t row = first_free_row; row <= e_pos_.row; ++row) {
+    free_chunk(row);
+  }
+  e_pos_ = new_e_pos;
+  sz_ -= count;
+}
+
+template <typename T>
+void Deque<T>::shift_left(size_t from, size_t to, size_t shift) {
+  if constexpr (std::is_trivially_copyable_v<T>) {
+    while (from < to) {
+      CellIndex<size_t> src = get_position_by_index(from);
+      CellIndex<size_t> dst = get_position_by_index(from - shift);
+      size_t count =
+          std::min({to - from, chunk_size_ - src.col, chunk_size_ - dst.col});
+      std::memmove(arr_[dst.row] + dst.col, arr_[src.row] + src.col,
+                   count * sizeof(T));
+      from += count;
+    }
+  } else {
+    if (from >= to) {
+      return;
+    }
+    CellIndex<size_t> src = get_position_by_index(from);
+    CellIndex<size_t> dst = get_position_by_index(from - shift);
+    for (; from < to; ++from, ++src, ++dst) {
+      arr_[dst.row][dst.col] = std::move(arr_[src.row][src.col]);
+    }
+  }
+}
+
+template <typename T>
+void Deque<T>::shift_right(size_t from, size_t to, size_t shift) {
+  if constexpr (std::is_trivially_copyable_v<T>) {
+    while (from < to) {
+      CellIndex<size_t> src = get_position_by_index(to - 1);
+      CellIndex<size_t> dst = get_position_by_index(to - 1 + shift);
+      size_t count = std::min({to - from, src.col + 1, dst.col + 1});
+      std::memmove(arr_[dst.row] + dst.col + 1 - count,
+                   arr_[src.row] + src.col + 1 - count, count * sizeof(T));
+      to -= count;
+    }
+  } else {
+    if (from >= to) {
+      return;
+    }
+    CellIndex<size_t> src = get_position_by_index(to - 1);
+    CellIndex<size_t> dst = get_position_by_index(to - 1 + shift);
+    for (; from < to; --to, --src, --dst) {
+      arr_[dst.row][dst.col] = std::move(arr_[src.row][src.col]);
+    }
+  }
+}
+
+// Makes room for count elements before index by moving the shorter side;
+// slots in [index, index + count) are left holding unspecified values.
+template <typename T>
+template <typename Source>
+void Deque<T>::open_gap(size_t index, size_t count, const Source& placeholder) {
+  size_t old_size = sz_;
+  if (index < old_size - index) {
+    size_t moved = std::min(count, index);
+    for (size_t i = moved; i < count; ++i) {
+      push_front(placeholder);
+    }
+    for (size_t i = 0; i < moved; ++i) {
+      push_front(std::move((*this)[count - 1]));
+    }
+    shift_left(count + moved, count + index, count);
+  } else {
+    size_t moved = std::min(count, old_size - index);
+    for (size_t i = moved; i < count; ++i) {
+      push_back(placeholder);
+    }
+    for (size_t i = 0; i < moved; ++i) {
+      push_back(std::move((*this)[sz_ - count]));
+    }
+    shift_right(index, old_size - moved, count);
   }
 }
 
+template <typename T>
+Deque<T>::Deque(size_t new_size) {
+  try {
+    construct_back(new_size, [](T* destination, size_t count) {
+      std::uninitialized_value_construct_n(destination, count);
+    });
+  } catch (...) {
+    clear_init();
+    clear_block();
+    throw;
+  }
+}
+
+template <typename T>
+std::span<T> Deque<T>::segment_from(size_t index) {
+  CellIndex<size_t> position = get_position_by_index(index);
+  return std::span<T>(arr_[position.row] + position.col,
+                      std::min(chunk_size_ - position.col, sz_ - index));
+}
+
+template <typename T>
+std::span<const T> Deque<T>::segment_from(size_t index) const {
+  CellIndex<size_t> position = get_position_by_index(index);
+  return std::span<const T>(arr_[position.row] + position.col,
+                            std::min(chunk_size_ - position.col, sz_ - index));
+}
+
 template <typename T>
 T& Deque<T>::operator[](size_t ind) {
   return *(begin() + ind);
@@ -484,20 +918,109 @@ Deque<T>::CellIndex<size_t> Deque<T>::get_position_by_index(
 
 template <typename T>
 Deque<T>::Deque(size_t new_size, const T& value) {
-  swap_with_unitianalized_deque(new_size);
-  for (size_t i = 0; i < static_cast<size_t>(new_size); ++i) {
-    CellIndex<size_t> new_index = get_position_by_index(i);
-    try {
-      new (arr_[new_index.row] + new_index.col) T(value);
-    } catch (...) {
-      for (size_t j = 0; j < i; ++j) {
-        (arr_[new_index.row] + new_index.col)->~T();
-      }
-      throw;
-    }
+  try {
+    construct_back(new_size, [&value](T* destination, size_t count) {
+      std::uninitialized_fill_n(destination, count, value);
+    });
+  } catch (...) {
+    clear_init();
+    clear_block();
+    throw;
+  }
+}
+
+template <typename T>
+template <typename ForwardIt, typename>
+Deque<T>::Deque(ForwardIt first, ForwardIt last) {
+  try {
+    assign(first, last);
+  } catch (...) {
+    clear_init();
+    clear_block();
+    throw;
   }
 }
 
+template <typename T>
+void Deque<T>::assign(size_t new_size, const T& value) {
+  clear();
+  construct_back(new_size, [&value](T* destination, size_t count) {
+    std::uninitialized_fill_n(destination, count, value);
+  });
+}
+
+template <typename T>
+template <typename ForwardIt, typename>
+void Deque<T>::assign(ForwardIt first, ForwardIt last) {
+  clear();
+  construct_back(std::distance(first, last),
+                 [&first](T* destination, size_t count) {
+                   if constexpr (std::is_trivially_copyable_v<T> &&
+                                 std::is_pointer_v<ForwardIt>) {
+                     std::memcpy(destination, first, count * sizeof(T));
+                     first += count;
+                   } else {
+                     ForwardIt segment_end = std::next(first, count);
+                     std::uninitialized_copy(first, segment_end, destination);
+                     first = segment_end;
+                   }
+                 });
+}
+
+template <typename T>
+void Deque<T>::resize(size_t new_size) {
+  if (new_size < sz_) {
+    destroy_back(sz_ - new_size);
+    return;
+  }
+  construct_back(new_size - sz_, [](T* destination, size_t count) {
+    std::uninitialized_value_construct_n(destination, count);
+  });
+}
+
+template <typename T>
+void Deque<T>::resize(size_t new_size, const T& value) {
+  if (new_size < sz_) {
+    destroy_back(sz_ - new_size);
+    return;
+  }
+  construct_back(new_size - sz_, [&value](T* destination, size_t count) {
+    std::uninitialized_fill_n(destination, count, value);
+  });
+}
+
+template <typename T>
+void Deque<T>::clear() {
+  if (arr_ != nullptr) {
+    destroy_back(sz_);
+  }
+}
+
+template <typename T>
+void Deque<T>::shrink_to_fit() {
+  if (sz_ == 0) {
+    clear_block();
+    arr_ = nullptr;
+    cap_ = 0;
+    b_pos_ = e_pos_ = {0, 0};
+    return;
+  }
+  size_t used_rows = e_pos_.row - b_pos_.row + 1;
+  if (used_rows == cap_) {
+    return;
+  }
+  T** new_arr = inline_map();
+  if (used_rows > 1 || arr_[b_pos_.row] != inline_chunk()) {
+    new_arr = new T*[used_rows];
+  }
+  std::copy(arr_ + b_pos_.row, arr_ + e_pos_.row + 1, new_arr);
+  delete[] arr_;
+  arr_ = new_arr;
+  cap_ = used_rows;
+  e_pos_.row -= b_pos_.row;
+  b_pos_.row = 0;
+}
+
 template <typename T>
 template <typename U>
 struct Deque<T>::CellIndex {
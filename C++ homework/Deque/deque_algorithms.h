@@ -0,0 +1,266 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <future>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <queue>
+#include <span>
+#include <thread>
+#include <vector>
+
+#include "deque.h"
+
+class ThreadPool {
+ public:
+  explicit ThreadPool(size_t threads_count) {
+    for (size_t i = 0; i < std::max<size_t>(threads_count, 1); ++i) {
+      workers_.emplace_back([this] { work(); });
+    }
+  }
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  ~ThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stopped_ = true;
+    }
+    has_tasks_.notify_all();
+    for (std::thread& worker : workers_) {
+      worker.join();
+    }
+  }
+
+  size_t size() const { return workers_.size(); }
+
+  template <typename F>
+  std::future<void> submit(F task) {
+    auto packaged =
+        std::make_shared<std::packaged_task<void()>>(std::move(task));
+    std::future<void> result = packaged->get_future();
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      tasks_.emplace([packaged] { (*packaged)(); });
+    }
+    has_tasks_.notify_one();
+    return result;
+  }
+
+  static ThreadPool& instance() {
+    static ThreadPool pool(std::thread::hardware_concurrency());
+    return pool;
+  }
+
+ private:
+  void work() {
+    while (true) {
+      std::function<void()> task;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        has_tasks_.wait(lock, [this] { return stopped_ || !tasks_.empty(); });
+        if (tasks_.empty()) {
+          return;
+        }
+        task = std::move(tasks_.front());
+        tasks_.pop();
+      }
+      task();
+    }
+  }
+
+  std::vector<std::thread> workers_;
+  std::queue<std::function<void()>> tasks_;
+  std::mutex mutex_;
+  std::condition_variable has_tasks_;
+  bool stopped_ = false;
+};
+
+namespace deque_detail {
+
+// Splits [0, size) into at most parts ranges whose inner borders fall on
+// chunk borders, so no two tasks ever touch the same chunk.
+template <typename T>
+std::vector<size_t> chunk_aligned_splits(const Deque<T>& deque,
+                                         size_t parts) {
+  std::vector<size_t> splits = {0};
+  size_t size = deque.size();
+  for (size_t part = 1; part < parts; ++part) {
+    size_t border = size * part / parts;
+    if (border < size) {
+      border += deque.segment_from(border).size();
+    }
+    if (border > splits.back() && border < size) {
+      splits.push_back(border);
+    }
+  }
+  if (size > 0) {
+    splits.push_back(size);
+  }
+  return splits;
+}
+
+// Waits for every future before rethrowing the first exception, since the
+// tasks still running refer to the caller's locals.
+inline void wait_all(std::vector<std::future<void>>& futures) {
+  std::exception_ptr error;
+  for (std::future<void>& future : futures) {
+    try {
+      future.get();
+    } catch (...) {
+      if (!error) {
+        error = std::current_exception();
+      }
+    }
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
+template <typename Body>
+void run_parts(ThreadPool& pool, const std::vector<size_t>& splits,
+               Body body) {
+  std::vector<std::future<void>> futures;
+  for (size_t part = 0; part + 1 < splits.size(); ++part) {
+    futures.push_back(pool.submit([&body, &splits, part] {
+      body(part, splits[part], splits[part + 1]);
+    }));
+  }
+  wait_all(futures);
+}
+
+template <typename DequeRef, typename SegmentFunction>
+void for_each_segment(DequeRef& deque, size_t from, size_t to,
+                      SegmentFunction function) {
+  while (from < to) {
+    auto segment = deque.segment_from(from);
+    segment = segment.first(std::min(to - from, segment.size()));
+    function(segment, from);
+    from += segment.size();
+  }
+}
+
+}  // namespace deque_detail
+
+template <typename T, typename F>
+void parallel_for_each(Deque<T>& deque, F function,
+                       ThreadPool& pool = ThreadPool::instance()) {
+  auto splits = deque_detail::chunk_aligned_splits(deque, pool.size());
+  deque_detail::run_parts(pool, splits, [&](size_t, size_t from, size_t to) {
+    deque_detail::for_each_segment(deque, from, to, [&](auto segment, size_t) {
+      std::for_each(segment.begin(), segment.end(), function);
+    });
+  });
+}
+
+template <typename T, typename U, typename F>
+void parallel_transform(const Deque<T>& source, Deque<U>& destination,
+                        F function, ThreadPool& pool = ThreadPool::instance()) {
+  destination.resize(source.size());
+  // Split on the destination's chunks: those are the ones written to, and
+  // the source may sit at a different offset within its chunks.
+  auto splits = deque_detail::chunk_aligned_splits(destination, pool.size());
+  deque_detail::run_parts(pool, splits, [&](size_t, size_t from, size_t to) {
+    deque_detail::for_each_segment(
+        destination, from, to, [&](std::span<U> output, size_t index) {
+          deque_detail::for_each_segment(
+              source, index, index + output.size(),
+              [&](std::span<const T> input, size_t input_index) {
+                std::transform(input.begin(), input.end(),
+                               output.begin() + (input_index - index),
+                               function);
+              });
+        });
+  });
+}
+
+template <typename T, typename Init, typename BinaryOp = std::plus<>>
+Init parallel_reduce(const Deque<T>& deque, Init init, BinaryOp op = {},
+                     ThreadPool& pool = ThreadPool::instance()) {
+  auto splits = deque_detail::chunk_aligned_splits(deque, pool.size());
+  std::vector<std::optional<Init>> partial(splits.size());
+  deque_detail::run_parts(
+      pool, splits, [&](size_t part, size_t from, size_t to) {
+        std::optional<Init>& accumulator = partial[part];
+        deque_detail::for_each_segment(
+            deque, from, to, [&](std::span<const T> segment, size_t) {
+              auto it = segment.begin();
+              if (!accumulator.has_value()) {
+                accumulator.emplace(*it++);
+              }
+              for (; it != segment.end(); ++it) {
+                *accumulator = op(std::move(*accumulator), *it);
+              }
+            });
+      });
+  for (std::optional<Init>& value : partial) {
+    if (value.has_value()) {
+      init = op(std::move(init), std::move(*value));
+    }
+  }
+  return init;
+}
+
+// Every part is moved into its own buffer and sorted there over raw
+// pointers, the buffers are merged pairwise, and the result is moved back.
+template <typename T, typename Compare = std::less<>>
+void parallel_sort(Deque<T>& deque, Compare compare = {},
+                   ThreadPool& pool = ThreadPool::instance()) {
+  auto splits = deque_detail::chunk_aligned_splits(deque, pool.size());
+  if (splits.size() <= 1) {
+    return;
+  }
+  std::vector<std::vector<T>> runs(splits.size() - 1);
+  deque_detail::run_parts(
+      pool, splits, [&](size_t part, size_t from, size_t to) {
+        std::vector<T>& run = runs[part];
+        run.reserve(to - from);
+        deque_detail::for_each_segment(
+            deque, from, to, [&](std::span<T> segment, size_t) {
+              std::move(segment.begin(), segment.end(),
+                        std::back_inserter(run));
+            });
+        std::sort(run.begin(), run.end(), compare);
+      });
+
+  while (runs.size() > 1) {
+    std::vector<std::vector<T>> merged((runs.size() + 1) / 2);
+    std::vector<std::future<void>> futures;
+    for (size_t i = 0; i < merged.size(); ++i) {
+      futures.push_back(pool.submit([&runs, &merged, &compare, i] {
+        if (2 * i + 1 == runs.size()) {
+          merged[i] = std::move(runs[2 * i]);
+          return;
+        }
+        std::vector<T>& left = runs[2 * i];
+        std::vector<T>& right = runs[2 * i + 1];
+        merged[i].reserve(left.size() + right.size());
+        std::merge(std::make_move_iterator(left.begin()),
+                   std::make_move_iterator(left.end()),
+                   std::make_move_iterator(right.begin()),
+                   std::make_move_iterator(right.end()),
+                   std::back_inserter(merged[i]), compare);
+        std::vector<T>().swap(left);
+        std::vector<T>().swap(right);
+      }));
+    }
+    deque_detail::wait_all(futures);
+    runs = std::move(merged);
+  }
+
+  std::vector<T>& sorted = runs.front();
+  deque_detail::run_parts(pool, splits, [&](size_t, size_t from, size_t to) {
+    deque_detail::for_each_segment(
+        deque, from, to, [&](std::span<T> segment, size_t index) {
+          std::move(sorted.begin() + index,
+                    sorted.begin() + index + segment.size(), segment.begin());
+        });
+  });
+}
@@ -0,0 +1,329 @@
+#pragma once
+
+#include <atomic>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+
+#include "deque.h"
+
+// Deque whose copies share chunks. Copying costs one reference count
+// increment per chunk; a chunk is duplicated only when one of its owners
+// first writes to it. Every chunk remembers which of its cells are
+// constructed, since owners may have popped different elements of it.
+template <typename T>
+class SnapshotDeque {
+ private:
+  static constexpr size_t chunk_size_ = 32;
+
+  struct Chunk {
+    std::atomic<size_t> refs{1};
+    size_t lo = 0;
+    size_t hi = 0;
+    alignas(T) char cells[chunk_size_ * sizeof(T)];
+
+    Chunk(size_t lo, size_t hi) : lo(lo), hi(hi) {}
+    T* cell(size_t col) { return reinterpret_cast<T*>(cells) + col; }
+  };
+
+  Deque<Chunk*> chunks_;
+  size_t b_col_ = 0;
+  size_t sz_ = 0;
+
+  static void release(Chunk* chunk);
+  size_t view_begin(size_t row) const { return row == 0 ? b_col_ : 0; }
+  size_t view_end(size_t row) const {
+    return std::min(chunk_size_, b_col_ + sz_ - row * chunk_size_);
+  }
+  Chunk* own(size_t row);
+  void release_all();
+
+ public:
+  SnapshotDeque() = default;
+  SnapshotDeque(const SnapshotDeque& another);
+  SnapshotDeque& operator=(const SnapshotDeque& another);
+  ~SnapshotDeque() { release_all(); }
+
+  SnapshotDeque snapshot() const { return *this; }
+
+  size_t size() const { return sz_; }
+  const T& operator[](size_t index) const;
+  T& operator[](size_t index);
+  const T& at(size_t index) const;
+
+  template <typename... Args>
+  void emplace_back(Args&&... args);
+  template <typename... Args>
+  void emplace_front(Args&&... args);
+  void push_back(const T& value) { emplace_back(value); }
+  void push_back(T&& value) { emplace_back(std::move(value)); }
+  void push_front(const T& value) { emplace_front(value); }
+  void push_front(T&& value) { emplace_front(std::move(value)); }
+  void pop_back();
+  void pop_front();
+
+  class const_iterator {
+   public:
+    using value_type = T;
+    using reference = const T&;
+    using pointer = const T*;
+    using iterator_category = std::random_access_iterator_tag;
+    using difference_type = ptrdiff_t;
+
+    const_iterator() = default;
+
+    reference operator*() const { return (*deque_)[index_]; }
+    pointer operator->() const { return &(*deque_)[index_]; }
+    reference operator[](difference_type shift) const {
+      return (*deque_)[index_ + shift];
+    }
+
+    const_iterator& operator++() {
+      ++index_;
+      return *this;
+    }
+    const_iterator operator++(int) {
+      const_iterator copy = *this;
+      ++index_;
+      return copy;
+    }
+    const_iterator& operator--() {
+      --index_;
+      return *this;
+    }
+    const_iterator operator--(int) {
+      const_iterator copy = *this;
+      --index_;
+      return copy;
+    }
+    const_iterator& operator+=(difference_type shift) {
+      index_ += shift;
+      return *this;
+    }
+    const_iterator& operator-=(difference_type shift) {
+      index_ -= shift;
+      return *this;
+    }
+    const_iterator operator+(difference_type shift) const {
+      return const_iterator(deque_, index_ + shift);
+    }
+    friend const_iterator operator+(difference_type shift,
+                                    const const_iterator& iter) {
+      return iter + shift;
+    }
+    const_iterator operator-(difference_type shift) const {
+      return const_iterator(deque_, index_ - shift);
+    }
+    difference_type operator-(const const_iterator& another) const {
+      return static_cast<difference_type>(index_) -
+             static_cast<difference_type>(another.index_);
+    }
+
+    bool operator==(const const_iterator& another) const {
+      return index_ == another.index_;
+    }
+    bool operator!=(const const_iterator& another) const {
+      return index_ != another.index_;
+    }
+    bool operator<(const const_iterator& another) const {
+      return index_ < another.index_;
+    }
+    bool operator>(const const_iterator& another) const {
+      return another < *this;
+    }
+    bool operator<=(const const_iterator& another) const {
+      return !(another < *this);
+    }
+    bool operator>=(const const_iterator& another) const {
+      return !(*this < another);
+    }
+
+   private:
+    const_iterator(const SnapshotDeque* deque, size_t index)
+        : deque_(deque), index_(index) {}
+
+    friend SnapshotDeque;
+
+    const SnapshotDeque* deque_ = nullptr;
+    size_t index_ = 0;
+  };
+
+  const_iterator begin() const { return const_iterator(this, 0); }
+  const_iterator end() const { return const_iterator(this, sz_); }
+  const_iterator cbegin() const { return begin(); }
+  const_iterator cend() const { return end(); }
+};
+
+template <typename T>
+void SnapshotDeque<T>::release(Chunk* chunk) {
+  if (chunk->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    std::destroy(chunk->cell(chunk->lo), chunk->cell(chunk->hi));
+    delete chunk;
+  }
+}
+
+template <typename T>
+void SnapshotDeque<T>::release_all() {
+  for (size_t row = 0; row < chunks_.size(); ++row) {
+    release(chunks_[row]);
+  }
+  chunks_.clear();
+  b_col_ = 0;
+  sz_ = 0;
+}
+
+// Makes the chunk at row private to this deque and trims its constructed
+// cells down to the ones this deque can see.
+template <typename T>
+typename SnapshotDeque<T>::Chunk* SnapshotDeque<T>::own(size_t row) {
+  Chunk* chunk = chunks_[row];
+  size_t first = view_begin(row);
+  size_t last = std::max(first, view_end(row));
+  if (chunk->refs.load(std::memory_order_acquire) == 1) {
+    std::destroy(chunk->cell(chunk->lo), chunk->cell(first));
+    std::destroy(chunk->cell(last), chunk->cell(chunk->hi));
+    chunk->lo = first;
+    chunk->hi = last;
+    return chunk;
+  }
+  Chunk* copy = new Chunk(first, first);
+  try {
+    std::uninitialized_copy(chunk->cell(first), chunk->cell(last),
+                            copy->cell(first));
+  } catch (...) {
+    delete copy;
+    throw;
+  }
+  copy->hi = last;
+  chunks_[row] = copy;
+  release(chunk);
+  return copy;
+}
+
+template <typename T>
+SnapshotDeque<T>::SnapshotDeque(const SnapshotDeque& another)
+    : chunks_(another.chunks_), b_col_(another.b_col_), sz_(another.sz_) {
+  for (size_t row = 0; row < chunks_.size(); ++row) {
+    chunks_[row]->refs.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+template <typename T>
+SnapshotDeque<T>& SnapshotDeque<T>::operator=(const SnapshotDeque& another) {
+  if (&another == this) {
+    return *this;
+  }
+  release_all();
+  chunks_ = another.chunks_;
+  for (size_t row = 0; row < chunks_.size(); ++row) {
+    chunks_[row]->refs.fetch_add(1, std::memory_order_relaxed);
+  }
+  b_col_ = another.b_col_;
+  sz_ = another.sz_;
+  return *this;
+}
+
+template <typename T>
+const T& SnapshotDeque<T>::operator[](size_t index) const {
+  size_t position = b_col_ + index;
+  return *chunks_[position / chunk_size_]->cell(position % chunk_size_);
+}
+
+template <typename T>
+T& SnapshotDeque<T>::operator[](size_t index) {
+  size_t position = b_col_ + index;
+  return *own(position / chunk_size_)->cell(position % chunk_size_);
+}
+
+template <typename T>
+const T& SnapshotDeque<T>::at(size_t index) const {
+  if (index >= sz_) {
+    throw std::out_of_range("");
+  }
+  return (*this)[index];
+}
+
+template <typename T>
+template <typename... Args>
+void SnapshotDeque<T>::emplace_back(Args&&... args) {
+  size_t position = b_col_ + sz_;
+  size_t row = position / chunk_size_;
+  size_t col = position % chunk_size_;
+  if (row == chunks_.size()) {
+    chunks_.push_back(new Chunk(0, 0));
+  }
+  Chunk* chunk = nullptr;
+  try {
+    chunk = own(row);
+    new (chunk->cell(col)) T(std::forward<Args>(args)...);
+  } catch (...) {
+    if (col == 0) {
+      release(chunks_[row]);
+      chunks_.pop_back();
+    }
+    throw;
+  }
+  chunk->hi = col + 1;
+  ++sz_;
+}
+
+template <typename T>
+template <typename... Args>
+void SnapshotDeque<T>::emplace_front(Args&&... args) {
+  if (b_col_ == 0) {
+    chunks_.push_front(new Chunk(chunk_size_, chunk_size_));
+    b_col_ = chunk_size_;
+  }
+  Chunk* chunk = nullptr;
+  try {
+    chunk = own(0);
+    new (chunk->cell(b_col_ - 1)) T(std::forward<Args>(args)...);
+  } catch (...) {
+    if (b_col_ == chunk_size_) {
+      release(chunks_[0]);
+      chunks_.pop_front();
+      b_col_ = 0;
+    }
+    throw;
+  }
+  --b_col_;
+  chunk->lo = b_col_;
+  ++sz_;
+}
+
+template <typename T>
+void SnapshotDeque<T>::pop_back() {
+  size_t position = b_col_ + sz_ - 1;
+  size_t row = position / chunk_size_;
+  size_t col = position % chunk_size_;
+  if (chunks_[row]->refs.load(std::memory_order_acquire) == 1) {
+    Chunk* chunk = own(row);
+    chunk->cell(col)->~T();
+    chunk->hi = col;
+  }
+  --sz_;
+  if (sz_ == 0) {
+    release_all();
+  } else if (col == 0) {
+    release(chunks_[row]);
+    chunks_.pop_back();
+  }
+}
+
+template <typename T>
+void SnapshotDeque<T>::pop_front() {
+  if (chunks_[0]->refs.load(std::memory_order_acquire) == 1) {
+    Chunk* chunk = own(0);
+    chunk->cell(b_col_)->~T();
+    chunk->lo = b_col_ + 1;
+  }
+  ++b_col_;
+  --sz_;
+  if (sz_ == 0) {
+    release_all();
+  } else if (b_col_ == chunk_size_) {
+    release(chunks_[0]);
+    chunks_.pop_front();
+    b_col_ = 0;
+  }
+}
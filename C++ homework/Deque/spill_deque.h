@@ -0,0 +1,269 @@
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <type_traits>
+
+#include "deque.h"
+
+// Queue of trivially copyable values that may outgrow memory. Only the first
+// and last few chunks stay in memory; every chunk in between is copied into
+// a slot of an unlinked temporary file through mmap and released, and is
+// read back once it gets close to one of the ends again.
+template <typename T>
+class SpillDeque {
+  static_assert(std::is_trivially_copyable_v<T>,
+                "SpillDeque stores raw bytes of T on disk");
+
+ private:
+  static constexpr size_t chunk_bytes_ = 1 << 16;
+  static constexpr size_t chunk_size_ = chunk_bytes_ / sizeof(T);
+  static_assert(chunk_size_ > 0, "T does not fit into a chunk");
+
+  struct Chunk {
+    T* memory;
+    size_t slot;
+  };
+
+  Deque<Chunk> chunks_;
+  size_t b_col_ = 0;
+  size_t sz_ = 0;
+  size_t keep_;
+  std::string directory_;
+
+  int fd_ = -1;
+  size_t slots_ = 0;
+  Deque<size_t> free_slots_;
+
+  static T* allocate_chunk() {
+    return std::allocator<T>().allocate(chunk_size_);
+  }
+  static void free_chunk(T* memory) {
+    std::allocator<T>().deallocate(memory, chunk_size_);
+  }
+  static void throw_errno() {
+    throw std::system_error(errno, std::generic_category());
+  }
+
+  size_t take_slot();
+  void spill(Chunk& chunk);
+  void load(Chunk& chunk);
+  void settle(size_t row);
+  void drop(Chunk& chunk);
+  T* cell(size_t index) const;
+
+ public:
+  explicit SpillDeque(size_t resident_chunks = 8,
+                      std::string directory = "/tmp")
+      : keep_(std::max<size_t>(resident_chunks / 2, 1)),
+        directory_(std::move(directory)) {}
+  SpillDeque(const SpillDeque&) = delete;
+  SpillDeque& operator=(const SpillDeque&) = delete;
+  ~SpillDeque();
+
+  size_t size() const { return sz_; }
+  bool empty() const { return sz_ == 0; }
+  size_t spilled_chunks() const { return slots_ - free_slots_.size(); }
+
+  const T& front() const { return *cell(0); }
+  const T& back() const { return *cell(sz_ - 1); }
+  T operator[](size_t index) const;
+
+  void push_back(const T& value);
+  void push_front(const T& value);
+  void pop_back();
+  void pop_front();
+  void clear();
+};
+
+template <typename T>
+size_t SpillDeque<T>::take_slot() {
+  if (free_slots_.size() > 0) {
+    size_t slot = free_slots_[free_slots_.size() - 1];
+    free_slots_.pop_back();
+    return slot;
+  }
+  if (fd_ == -1) {
+    std::string path = directory_ + "/spill_deque.XXXXXX";
+    fd_ = mkstemp(path.data());
+    if (fd_ == -1) {
+      throw_errno();
+    }
+    unlink(path.c_str());
+  }
+  if (ftruncate(fd_, (slots_ + 1) * chunk_bytes_) == -1) {
+    throw_errno();
+  }
+  return slots_++;
+}
+
+template <typename T>
+void SpillDeque<T>::spill(Chunk& chunk) {
+  size_t slot = take_slot();
+  void* mapped = mmap(nullptr, chunk_bytes_, PROT_WRITE, MAP_SHARED, fd_,
+                      slot * chunk_bytes_);
+  if (mapped == MAP_FAILED) {
+    free_slots_.push_back(slot);
+    throw_errno();
+  }
+  std::memcpy(mapped, chunk.memory, chunk_size_ * sizeof(T));
+  munmap(mapped, chunk_bytes_);
+  free_chunk(chunk.memory);
+  chunk = {nullptr, slot};
+}
+
+template <typename T>
+void SpillDeque<T>::load(Chunk& chunk) {
+  T* memory = allocate_chunk();
+  void* mapped = mmap(nullptr, chunk_bytes_, PROT_READ, MAP_SHARED, fd_,
+                      chunk.slot * chunk_bytes_);
+  if (mapped == MAP_FAILED) {
+    free_chunk(memory);
+    throw_errno();
+  }
+  std::memcpy(memory, mapped, chunk_size_ * sizeof(T));
+  munmap(mapped, chunk_bytes_);
+  free_slots_.push_back(chunk.slot);
+  chunk = {memory, 0};
+}
+
+// A row stays in memory iff it is among the keep_ first or keep_ last rows.
+template <typename T>
+void SpillDeque<T>::settle(size_t row) {
+  if (row >= chunks_.size()) {
+    return;
+  }
+  Chunk& chunk = chunks_[row];
+  bool hot = row < keep_ || row + keep_ >= chunks_.size();
+  if (hot && chunk.memory == nullptr) {
+    load(chunk);
+  } else if (!hot && chunk.memory != nullptr) {
+    spill(chunk);
+  }
+}
+
+template <typename T>
+void SpillDeque<T>::drop(Chunk& chunk) {
+  if (chunk.memory != nullptr) {
+    free_chunk(chunk.memory);
+  } else {
+    free_slots_.push_back(chunk.slot);
+  }
+}
+
+template <typename T>
+T* SpillDeque<T>::cell(size_t index) const {
+  size_t position = b_col_ + index;
+  return chunks_[position / chunk_size_].memory + position % chunk_size_;
+}
+
+template <typename T>
+SpillDeque<T>::~SpillDeque() {
+  clear();
+  if (fd_ != -1) {
+    close(fd_);
+  }
+}
+
+template <typename T>
+T SpillDeque<T>::operator[](size_t index) const {
+  size_t position = b_col_ + index;
+  const Chunk& chunk = chunks_[position / chunk_size_];
+  if (chunk.memory != nullptr) {
+    return chunk.memory[position % chunk_size_];
+  }
+  T value;
+  off_t offset =
+      chunk.slot * chunk_bytes_ + position % chunk_size_ * sizeof(T);
+  if (pread(fd_, &value, sizeof(T), offset) != sizeof(T)) {
+    throw_errno();
+  }
+  return value;
+}
+
+template <typename T>
+void SpillDeque<T>::push_back(const T& value) {
+  size_t position = b_col_ + sz_;
+  bool new_row = position / chunk_size_ == chunks_.size();
+  if (new_row) {
+    T* memory = allocate_chunk();
+    try {
+      chunks_.push_back({memory, 0});
+    } catch (...) {
+      free_chunk(memory);
+      throw;
+    }
+  }
+  new (chunks_[position / chunk_size_].memory + position % chunk_size_)
+      T(value);
+  ++sz_;
+  if (new_row && chunks_.size() > keep_) {
+    settle(chunks_.size() - 1 - keep_);
+  }
+}
+
+template <typename T>
+void SpillDeque<T>::push_front(const T& value) {
+  bool new_row = b_col_ == 0;
+  if (new_row) {
+    T* memory = allocate_chunk();
+    try {
+      chunks_.push_front({memory, 0});
+    } catch (...) {
+      free_chunk(memory);
+      throw;
+    }
+    b_col_ = chunk_size_;
+  }
+  --b_col_;
+  new (chunks_[0].memory + b_col_) T(value);
+  ++sz_;
+  if (new_row) {
+    settle(keep_);
+  }
+}
+
+template <typename T>
+void SpillDeque<T>::pop_back() {
+  --sz_;
+  if (sz_ == 0) {
+    clear();
+  } else if ((b_col_ + sz_) % chunk_size_ == 0) {
+    drop(chunks_[chunks_.size() - 1]);
+    chunks_.pop_back();
+    if (chunks_.size() >= keep_) {
+      settle(chunks_.size() - keep_);
+    }
+  }
+}
+
+template <typename T>
+void SpillDeque<T>::pop_front() {
+  ++b_col_;
+  --sz_;
+  if (sz_ == 0) {
+    clear();
+  } else if (b_col_ == chunk_size_) {
+    drop(chunks_[0]);
+    chunks_.pop_front();
+    b_col_ = 0;
+    settle(keep_ - 1);
+  }
+}
+
+template <typename T>
+void SpillDeque<T>::clear() {
+  for (size_t row = 0; row < chunks_.size(); ++row) {
+    drop(chunks_[row]);
+  }
+  chunks_.clear();
+  b_col_ = 0;
+  sz_ = 0;
+}
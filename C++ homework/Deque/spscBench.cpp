@@ -0,0 +1,74 @@
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+#include "deque.h"
+#include "spsc_deque.h"
+
+// Producer/consumer throughput: SpscDeque against a Deque guarded by a mutex.
+
+constexpr int kItems = 10'000'000;
+
+template <typename Push, typename Pop>
+long long RunPair(Push push, Pop pop) {
+  using namespace std::chrono;
+  auto start = steady_clock::now();
+  std::thread producer([&push] {
+    for (int i = 0; i < kItems; ++i) {
+      push(i);
+    }
+  });
+  long long checksum = 0;
+  int value = 0;
+  for (int i = 0; i < kItems; ++i) {
+    while (!pop(value)) {
+      std::this_thread::yield();
+    }
+    checksum += value;
+  }
+  producer.join();
+  auto finish = steady_clock::now();
+  if (checksum != 1LL * kItems * (kItems - 1) / 2) {
+    std::cerr << "checksum mismatch\n";
+    std::abort();
+  }
+  return duration_cast<milliseconds>(finish - start).count();
+}
+
+long long SpscRun() {
+  SpscDeque<int> queue;
+  return RunPair([&queue](int i) { queue.push_back(i); },
+                 [&queue](int& value) { return queue.try_pop_front(value); });
+}
+
+long long MutexRun() {
+  Deque<int> queue;
+  std::mutex mutex;
+  return RunPair(
+      [&](int i) {
+        std::lock_guard<std::mutex> lock(mutex);
+        queue.push_back(i);
+      },
+      [&](int& value) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (queue.size() == 0) {
+          return false;
+        }
+        value = queue[0];
+        queue.pop_front();
+        return true;
+      });
+}
+
+void Report(const char* name, long long ms) {
+  std::cout << name << ": " << ms << " ms, "
+            << (ms == 0 ? 0 : kItems / ms / 1000) << " Mops/s" << std::endl;
+}
+
+int main() {
+  for (int round = 0; round < 3; ++round) {
+    Report("SpscDeque          ", SpscRun());
+    Report("std::mutex + Deque ", MutexRun());
+  }
+}
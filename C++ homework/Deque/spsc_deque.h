@@ -0,0 +1,134 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <utility>
+
+// Unbounded queue for exactly one producer thread and one consumer thread.
+// Storage is the same chunked layout as Deque: the producer appends chunks at
+// the back, the consumer releases them from the front. Each chunk publishes
+// how many of its cells are constructed, so push and pop never wait on each
+// other.
+template <typename T>
+class SpscDeque {
+ private:
+  static const size_t chunk_size_ = 32;
+  static const size_t cache_line_ = 64;
+
+  struct Chunk {
+    alignas(T) char cells[chunk_size_ * sizeof(T)];
+    std::atomic<size_t> published{0};
+    std::atomic<Chunk*> next{nullptr};
+
+    T* cell(size_t index) { return reinterpret_cast<T*>(cells) + index; }
+  };
+
+  alignas(cache_line_) Chunk* head_ = nullptr;
+  size_t head_col_ = 0;
+
+  alignas(cache_line_) Chunk* tail_ = nullptr;
+  size_t tail_col_ = 0;
+
+  alignas(cache_line_) std::atomic<Chunk*> spare_{nullptr};
+
+  Chunk* acquire_chunk();
+  void release_chunk(Chunk* chunk);
+
+ public:
+  SpscDeque() : head_(new Chunk()), tail_(head_) {}
+  SpscDeque(const SpscDeque&) = delete;
+  SpscDeque& operator=(const SpscDeque&) = delete;
+  ~SpscDeque();
+
+  template <typename... Args>
+  void emplace_back(Args&&... args);
+  void push_back(const T& value) { emplace_back(value); }
+  void push_back(T&& value) { emplace_back(std::move(value)); }
+
+  // Consumer thread only. empty() reads the consumer's position too, so
+  // calling it from the producer would race with try_pop_front.
+  bool try_pop_front(T& value);
+  bool empty() const;
+};
+
+template <typename T>
+typename SpscDeque<T>::Chunk* SpscDeque<T>::acquire_chunk() {
+  Chunk* chunk = spare_.exchange(nullptr, std::memory_order_acquire);
+  if (chunk == nullptr) {
+    return new Chunk();
+  }
+  chunk->published.store(0, std::memory_order_relaxed);
+  chunk->next.store(nullptr, std::memory_order_relaxed);
+  return chunk;
+}
+
+template <typename T>
+void SpscDeque<T>::release_chunk(Chunk* chunk) {
+  Chunk* expected = nullptr;
+  if (!spare_.compare_exchange_strong(expected, chunk,
+                                      std::memory_order_release,
+                                      std::memory_order_relaxed)) {
+    delete chunk;
+  }
+}
+
+template <typename T>
+template <typename... Args>
+void SpscDeque<T>::emplace_back(Args&&... args) {
+  if (tail_col_ == chunk_size_) {
+    Chunk* chunk = acquire_chunk();
+    tail_->next.store(chunk, std::memory_order_release);
+    tail_ = chunk;
+    tail_col_ = 0;
+  }
+  new (tail_->cell(tail_col_)) T(std::forward<Args>(args)...);
+  ++tail_col_;
+  tail_->published.store(tail_col_, std::memory_order_release);
+}
+
+template <typename T>
+bool SpscDeque<T>::try_pop_front(T& value) {
+  if (head_col_ == chunk_size_) {
+    Chunk* next = head_->next.load(std::memory_order_acquire);
+    if (next == nullptr) {
+      return false;
+    }
+    release_chunk(head_);
+    head_ = next;
+    head_col_ = 0;
+  }
+  if (head_col_ == head_->published.load(std::memory_order_acquire)) {
+    return false;
+  }
+  T* cell = head_->cell(head_col_);
+  value = std::move(*cell);
+  cell->~T();
+  ++head_col_;
+  return true;
+}
+
+template <typename T>
+bool SpscDeque<T>::empty() const {
+  if (head_col_ < chunk_size_) {
+    return head_col_ == head_->published.load(std::memory_order_acquire);
+  }
+  Chunk* next = head_->next.load(std::memory_order_acquire);
+  return next == nullptr ||
+         next->published.load(std::memory_order_acquire) == 0;
+}
+
+template <typename T>
+SpscDeque<T>::~SpscDeque() {
+  while (head_ != nullptr) {
+    size_t published = head_->published.load(std::memory_order_acquire);
+    for (; head_col_ < published; ++head_col_) {
+      head_->cell(head_col_)->~T();
+    }
+    Chunk* next = head_->next.load(std::memory_order_acquire);
+    delete head_;
+    head_ = next;
+    head_col_ = 0;
+  }
+  delete spare_.load(std::memory_order_acquire);
+}
@@ -0,0 +1,290 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <list>
+#include <memory>
+#include <random>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "memory_resource.h"
+#include "stackallocator.h"
+
+// ListPerformanceTest grown into a matrix: List and std::list under
+// std::allocator, StackAllocator and a PoolResource, for several element
+// sizes and three operation mixes. Every cell reports throughput, hardware
+// cache misses per operation where perf counters are available, and the
+// peak number of bytes the container held through its allocator.
+
+constexpr size_t kOperations = 2'000'000;
+constexpr int kRounds = 3;
+constexpr size_t kQueueLength = 1'000;
+constexpr size_t kLifoDepth = 1'000;
+constexpr size_t kRandomLength = 10'000;
+constexpr size_t kStorageSize = 64'000'000;
+
+volatile size_t sink = 0;
+
+template <size_t Size>
+struct Payload {
+  char bytes[Size];
+  explicit Payload(size_t value) { std::memset(bytes, value, Size); }
+};
+
+struct Footprint {
+  size_t live = 0;
+  size_t peak = 0;
+};
+
+// Forwards to Alloc and keeps track of the bytes it holds.
+template <typename T, typename Alloc>
+class Counted {
+ public:
+  using value_type = T;
+
+  template <typename U>
+  struct rebind {
+    using other = Counted<
+        U, typename std::allocator_traits<Alloc>::template rebind_alloc<U>>;
+  };
+
+  Counted(Alloc alloc, Footprint* footprint)
+      : alloc_(alloc), footprint_(footprint) {}
+  template <typename U, typename A>
+  Counted(const Counted<U, A>& another)
+      : alloc_(another.alloc_), footprint_(another.footprint_) {}
+
+  T* allocate(size_t n) {
+    T* result = alloc_.allocate(n);
+    footprint_->live += n * sizeof(T);
+    footprint_->peak = std::max(footprint_->peak, footprint_->live);
+    return result;
+  }
+  void deallocate(T* ptr, size_t n) {
+    footprint_->live -= n * sizeof(T);
+    alloc_.deallocate(ptr, n);
+  }
+
+  bool operator==(const Counted& another) const {
+    return alloc_ == another.alloc_;
+  }
+  bool operator!=(const Counted& another) const {
+    return alloc_ != another.alloc_;
+  }
+
+ private:
+  template <typename, typename>
+  friend class Counted;
+
+  Alloc alloc_;
+  Footprint* footprint_;
+};
+
+class CacheMissCounter {
+ public:
+  CacheMissCounter() {
+#ifdef __linux__
+    perf_event_attr attr{};
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    fd_ = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+#endif
+  }
+  CacheMissCounter(const CacheMissCounter&) = delete;
+  ~CacheMissCounter() {
+#ifdef __linux__
+    if (fd_ >= 0) {
+      close(fd_);
+    }
+#endif
+  }
+
+  bool available() const { return fd_ >= 0; }
+
+  void start() {
+#ifdef __linux__
+    if (fd_ >= 0) {
+      ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+      ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+  }
+  long long stop() {
+    long long count = 0;
+#ifdef __linux__
+    if (fd_ >= 0) {
+      ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+      if (read(fd_, &count, sizeof(count)) != sizeof(count)) {
+        count = 0;
+      }
+    }
+#endif
+    return count;
+  }
+
+ private:
+  int fd_ = -1;
+};
+
+// Keeps kQueueLength elements, pushing at the back and popping at the front.
+template <typename Container>
+void Fifo(Container& c) {
+  using Value = std::decay_t<decltype(*c.begin())>;
+  for (size_t i = 0; i < kOperations; ++i) {
+    c.push_back(Value(i));
+    if (c.size() > kQueueLength) {
+      sink = c.begin()->bytes[0];
+      c.pop_front();
+    }
+  }
+}
+
+// Grows to kLifoDepth elements and shrinks back, over and over.
+template <typename Container>
+void Lifo(Container& c) {
+  using Value = std::decay_t<decltype(*c.begin())>;
+  for (size_t i = 0; i < kOperations / (2 * kLifoDepth); ++i) {
+    for (size_t j = 0; j < kLifoDepth; ++j) {
+      c.push_back(Value(j));
+    }
+    for (size_t j = 0; j < kLifoDepth; ++j) {
+      sink = c.rbegin()->bytes[0];
+      c.pop_back();
+    }
+  }
+}
+
+// Alternately erases a random element and inserts before a random one.
+template <typename Container>
+void Random(Container& c) {
+  using Value = std::decay_t<decltype(*c.begin())>;
+  std::vector<typename Container::iterator> positions;
+  for (size_t i = 0; i < kRandomLength; ++i) {
+    c.push_back(Value(i));
+    positions.push_back(std::prev(c.end()));
+  }
+  std::mt19937 g(1);
+  for (size_t i = 0; i < kOperations / 2; ++i) {
+    size_t victim = g() % positions.size();
+    sink = positions[victim]->bytes[0];
+    c.erase(positions[victim]);
+    positions[victim] = positions.back();
+    positions.pop_back();
+    auto pos = positions[g() % positions.size()];
+    positions.push_back(c.insert(pos, Value(i)));
+  }
+}
+
+struct Cell {
+  double mops = 0;
+  double misses_per_op = 0;
+  size_t peak = 0;
+};
+
+// Best of kRounds, each on a fresh container.
+template <typename Container, typename Alloc>
+Cell Measure(void (*mix)(Container&), const Alloc& alloc,
+             Footprint& footprint, CacheMissCounter& counter) {
+  Cell best;
+  for (int round = 0; round < kRounds; ++round) {
+    Container c(alloc);
+    auto start = std::chrono::steady_clock::now();
+    counter.start();
+    mix(c);
+    long long misses = counter.stop();
+    auto finish = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(finish - start).count();
+    if (kOperations / seconds / 1e6 > best.mops) {
+      best.mops = kOperations / seconds / 1e6;
+      best.misses_per_op = static_cast<double>(misses) / kOperations;
+    }
+  }
+  best.peak = footprint.peak;
+  return best;
+}
+
+enum class AllocatorKind { kStd, kStack, kPool };
+
+template <template <typename, typename> class Container, typename T>
+Cell Run(AllocatorKind kind, int mix, CacheMissCounter& counter) {
+  Footprint footprint;
+  auto pick = [mix](auto* tag) {
+    using C = std::remove_pointer_t<decltype(tag)>;
+    void (*mixes[])(C&) = {Fifo<C>, Lifo<C>, Random<C>};
+    return mixes[mix];
+  };
+  if (kind == AllocatorKind::kStd) {
+    using Alloc = Counted<T, std::allocator<T>>;
+    using C = Container<T, Alloc>;
+    return Measure<C>(pick(static_cast<C*>(nullptr)),
+                      Alloc(std::allocator<T>(), &footprint), footprint,
+                      counter);
+  }
+  if (kind == AllocatorKind::kStack) {
+    auto storage = std::make_unique<StackStorage<kStorageSize>>();
+    using Alloc = Counted<T, StackAllocator<T, kStorageSize>>;
+    using C = Container<T, Alloc>;
+    return Measure<C>(
+        pick(static_cast<C*>(nullptr)),
+        Alloc(StackAllocator<T, kStorageSize>(*storage), &footprint),
+        footprint, counter);
+  }
+  PoolResource pool;
+  using Alloc = Counted<T, PolymorphicAllocator<T>>;
+  using C = Container<T, Alloc>;
+  return Measure<C>(pick(static_cast<C*>(nullptr)),
+                    Alloc(PolymorphicAllocator<T>(&pool), &footprint),
+                    footprint, counter);
+}
+
+template <size_t Size>
+void RunSize(CacheMissCounter& counter) {
+  const char* mixes[] = {"fifo", "lifo", "random"};
+  const char* allocators[] = {"std", "stack", "pool"};
+  using T = Payload<Size>;
+  for (int mix = 0; mix < 3; ++mix) {
+    for (int kind = 0; kind < 3; ++kind) {
+      Cell list = Run<List, T>(AllocatorKind(kind), mix, counter);
+      Cell std_list = Run<std::list, T>(AllocatorKind(kind), mix, counter);
+      std::printf("%-6zu %-8s %-6s", Size, mixes[mix], allocators[kind]);
+      for (const Cell& cell : {list, std_list}) {
+        std::printf(" %9.2f", cell.mops);
+        if (counter.available()) {
+          std::printf(" %8.2f", cell.misses_per_op);
+        } else {
+          std::printf(" %8s", "n/a");
+        }
+        std::printf(" %9zu", cell.peak / 1024);
+      }
+      std::printf("\n");
+    }
+  }
+}
+
+int main() {
+  CacheMissCounter counter;
+  std::printf("%-6s %-8s %-6s %9s %8s %9s %9s %8s %9s\n", "bytes", "mix",
+              "alloc", "List", "miss/op", "peak KiB", "std::list", "miss/op",
+              "peak KiB");
+  RunSize<8>(counter);
+  RunSize<64>(counter);
+  RunSize<256>(counter);
+  std::printf("(million operations per second, best of %d rounds of %zu)\n",
+              kRounds, kOperations);
+  if (!counter.available()) {
+    std::printf("(perf counters are not available here)\n");
+  }
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "stackallocator.h"
+
+// StackStorage that any number of threads may allocate from at once: the
+// bump offset is advanced with a compare-and-swap. Freed memory is reclaimed
+// only when it is the most recent allocation.
+template <size_t N>
+class AtomicStackStorage {
+ public:
+  AtomicStackStorage() = default;
+  AtomicStackStorage(const AtomicStackStorage&) = delete;
+
+  void* allocate(size_t n, size_t sz_of, size_t alignment) {
+    size_t bytes = sz_of * n;
+    uintptr_t base = reinterpret_cast<uintptr_t>(buffer_);
+    size_t offset = offset_.load(std::memory_order_acquire);
+    while (true) {
+      size_t begin =
+          (base + offset + alignment - 1) / alignment * alignment - base;
+      if (begin + bytes > N) {
+        return nullptr;
+      }
+      if (offset_.compare_exchange_weak(offset, begin + bytes,
+                                        std::memory_order_acq_rel,
+                                        std::memory_order_acquire)) {
+        return buffer_ + begin;
+      }
+    }
+  }
+  void deallocate(void* ptr, size_t n, size_t sz_of) {
+    size_t begin = static_cast<char*>(ptr) - buffer_;
+    size_t end = begin + sz_of * n;
+    offset_.compare_exchange_strong(end, begin, std::memory_order_acq_rel,
+                                    std::memory_order_relaxed);
+  }
+
+ private:
+  alignas(64) std::atomic<size_t> offset_{0};
+  alignas(64) char buffer_[N];
+};
+
+// Every thread carves slabs of slab_size_ bytes out of a shared
+// AtomicStackStorage and bumps inside its own slab without synchronization.
+// A thread keeps one slab at a time, so switching between several storages
+// abandons the rest of the previous slab.
+template <size_t N>
+class ThreadCachedStackStorage {
+ public:
+  ThreadCachedStackStorage() : id_(next_id()) {}
+  ThreadCachedStackStorage(const ThreadCachedStackStorage&) = delete;
+
+  void* allocate(size_t n, size_t sz_of, size_t alignment) {
+    size_t bytes = sz_of * n;
+    if (bytes > slab_size_ / 4) {
+      return parent_.allocate(n, sz_of, alignment);
+    }
+    Cache& cache = local_cache();
+    if (cache.owner != id_ ||
+        std::align(alignment, bytes, cache.ptr, cache.size) == nullptr) {
+      void* slab = parent_.allocate(slab_size_, 1, alignof(std::max_align_t));
+      if (slab == nullptr) {
+        return parent_.allocate(n, sz_of, alignment);
+      }
+      cache = {id_, slab, slab_size_};
+      std::align(alignment, bytes, cache.ptr, cache.size);
+    }
+    void* result = cache.ptr;
+    cache.ptr = static_cast<char*>(cache.ptr) + bytes;
+    cache.size -= bytes;
+    return result;
+  }
+  void deallocate(void* ptr, size_t n, size_t sz_of) {
+    size_t bytes = sz_of * n;
+    Cache& cache = local_cache();
+    if (cache.owner == id_ && static_cast<char*>(ptr) + bytes == cache.ptr) {
+      cache.ptr = ptr;
+      cache.size += bytes;
+    } else if (bytes > slab_size_ / 4) {
+      parent_.deallocate(ptr, n, sz_of);
+    }
+  }
+
+ private:
+  struct Cache {
+    size_t owner = 0;
+    void* ptr = nullptr;
+    size_t size = 0;
+  };
+  static const size_t slab_size_ = 1 << 16;
+
+  static Cache& local_cache() {
+    thread_local Cache cache;
+    return cache;
+  }
+  static size_t next_id() {
+    static std::atomic<size_t> last_id{0};
+    return last_id.fetch_add(1, std::memory_order_relaxed) + 1;
+  }
+
+  size_t id_;
+  AtomicStackStorage<N> parent_;
+};
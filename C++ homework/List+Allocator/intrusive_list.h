@@ -0,0 +1,268 @@
+#pragma once
+
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+#include "list_node.h"
+
+// What a hook does when its object is destroyed while still in a list.
+enum class HookMode {
+  kNormal,      // Nothing: the object has to be erased beforehand.
+  kAutoUnlink,  // Unlinks itself, so the list cannot keep a size counter.
+};
+
+struct DefaultHookTag;
+
+// Base class that makes T linkable into IntrusiveList<T, hook>. Deriving from
+// hooks with different tags puts one object into several lists at once.
+// Copies of a hook start unlinked, so objects stay copyable.
+template <typename Tag = DefaultHookTag, HookMode Mode = HookMode::kNormal>
+class IntrusiveListHook : private ListBaseNode {
+ public:
+  static constexpr HookMode mode = Mode;
+
+  IntrusiveListHook() = default;
+  IntrusiveListHook(const IntrusiveListHook&) : ListBaseNode() {}
+  IntrusiveListHook& operator=(const IntrusiveListHook&) { return *this; }
+  ~IntrusiveListHook() {
+    if constexpr (Mode == HookMode::kAutoUnlink) {
+      unlink();
+    }
+  }
+
+  bool is_linked() const { return next != nullptr; }
+
+  // Only auto-unlink lists do not count their nodes, so only their hooks
+  // may leave on their own.
+  void unlink() {
+    static_assert(Mode == HookMode::kAutoUnlink,
+                  "use IntrusiveList::erase for counted lists");
+    if (is_linked()) {
+      prev->next = next;
+      next->prev = prev;
+      prev = next = nullptr;
+    }
+  }
+
+ private:
+  template <typename, typename>
+  friend class IntrusiveList;
+};
+
+// Doubly-linked list over objects that carry their own links: it never
+// allocates, and erasing an object needs no search. The list does not own
+// its elements; it only has to be outlived by the ones it holds, except for
+// auto-unlink hooks. Like List, it links the nodes into a ring through
+// fake_node_.
+template <typename T, typename Hook = IntrusiveListHook<>>
+class IntrusiveList {
+ private:
+  static_assert(std::is_base_of_v<Hook, T>, "T has to derive from Hook");
+
+  using value_type = T;
+  using reference = T&;
+  using const_reference = const T&;
+  using size_type = std::size_t;
+  using difference_type = ptrdiff_t;
+  using BaseNode = ListBaseNode;
+
+  static constexpr bool constant_time_size_ =
+      Hook::mode != HookMode::kAutoUnlink;
+
+  static BaseNode* node_of(const_reference value) {
+    return const_cast<BaseNode*>(
+        static_cast<const BaseNode*>(static_cast<const Hook*>(&value)));
+  }
+  static T& value_of(BaseNode* node) {
+    return static_cast<T&>(*static_cast<Hook*>(node));
+  }
+
+  static void unlink(BaseNode* node) {
+    node->prev->next = node->next;
+    node->next->prev = node->prev;
+    node->prev = node->next = nullptr;
+  }
+
+  BaseNode fake_node_{&fake_node_, &fake_node_};
+  size_type sz_ = 0;
+
+ public:
+  template <bool IsConst>
+  class common_iterator {
+   public:
+    using Type = std::conditional_t<IsConst, const T, T>;
+    using reference = Type&;
+    using pointer = Type*;
+    using iterator_category = std::bidirectional_iterator_tag;
+    using value_type = T;
+    using difference_type = ptrdiff_t;
+
+    common_iterator() = default;
+
+    common_iterator(const common_iterator<false>& another)
+        : node_ptr_(another.node_ptr_) {}
+    common_iterator& operator=(const common_iterator<false>& another) {
+      node_ptr_ = another.node_ptr_;
+      return *this;
+    }
+
+    reference operator*() const { return value_of(node_ptr_); }
+    pointer operator->() const { return &value_of(node_ptr_); }
+
+    common_iterator& operator++() {
+      node_ptr_ = node_ptr_->next;
+      return *this;
+    }
+    common_iterator operator++(int) {
+      common_iterator copy_iter = *this;
+      node_ptr_ = node_ptr_->next;
+      return copy_iter;
+    }
+    common_iterator& operator--() {
+      node_ptr_ = node_ptr_->prev;
+      return *this;
+    }
+    common_iterator operator--(int) {
+      common_iterator copy_iter = *this;
+      node_ptr_ = node_ptr_->prev;
+      return copy_iter;
+    }
+
+    bool operator==(const common_iterator& another) const {
+      return node_ptr_ == another.node_ptr_;
+    }
+    bool operator!=(const common_iterator& another) const {
+      return node_ptr_ != another.node_ptr_;
+    }
+
+   private:
+    friend class IntrusiveList;
+    template <bool>
+    friend class common_iterator;
+
+    explicit common_iterator(BaseNode* ptr) : node_ptr_(ptr) {}
+
+    BaseNode* node_ptr_ = nullptr;
+  };
+
+  using iterator = common_iterator<false>;
+  using const_iterator = common_iterator<true>;
+  using reverse_iterator = std::reverse_iterator<iterator>;
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+  IntrusiveList() = default;
+  IntrusiveList(const IntrusiveList&) = delete;
+  IntrusiveList& operator=(const IntrusiveList&) = delete;
+  IntrusiveList(IntrusiveList&& another) noexcept
+      : fake_node_(another.fake_node_), sz_(another.sz_) {
+    if (another.fake_node_.next == &another.fake_node_) {
+      fake_node_ = {&fake_node_, &fake_node_};
+    } else {
+      fake_node_.next->prev = &fake_node_;
+      fake_node_.prev->next = &fake_node_;
+    }
+    another.fake_node_ = {&another.fake_node_, &another.fake_node_};
+    another.sz_ = 0;
+  }
+  IntrusiveList& operator=(IntrusiveList&& another) noexcept {
+    if (&another != this) {
+      clear();
+      splice(end(), another);
+    }
+    return *this;
+  }
+  ~IntrusiveList() { clear(); }
+
+  size_type size() const {
+    if constexpr (constant_time_size_) {
+      return sz_;
+    } else {
+      return std::distance(begin(), end());
+    }
+  }
+  bool empty() const { return fake_node_.next == &fake_node_; }
+
+  iterator begin() { return iterator(fake_node_.next); }
+  const_iterator begin() const { return const_iterator(fake_node_.next); }
+  const_iterator cbegin() const { return begin(); }
+  iterator end() { return iterator(&fake_node_); }
+  const_iterator end() const {
+    return const_iterator(const_cast<BaseNode*>(&fake_node_));
+  }
+  const_iterator cend() const { return end(); }
+
+  reverse_iterator rbegin() { return reverse_iterator(end()); }
+  const_reverse_iterator rbegin() const {
+    return const_reverse_iterator(end());
+  }
+  reverse_iterator rend() { return reverse_iterator(begin()); }
+  const_reverse_iterator rend() const {
+    return const_reverse_iterator(begin());
+  }
+
+  reference front() { return value_of(fake_node_.next); }
+  const_reference front() const { return value_of(fake_node_.next); }
+  reference back() { return value_of(fake_node_.prev); }
+  const_reference back() const { return value_of(fake_node_.prev); }
+
+  // Iterator to an object that is known to be in this list.
+  iterator iterator_to(reference value) { return iterator(node_of(value)); }
+  const_iterator iterator_to(const_reference value) const {
+    return const_iterator(node_of(value));
+  }
+
+  // value must not be linked into another list through the same hook.
+  iterator insert(const_iterator pos, reference value) {
+    BaseNode* node = node_of(value);
+    BaseNode* next = pos.node_ptr_;
+    node->prev = next->prev;
+    node->next = next;
+    next->prev->next = node;
+    next->prev = node;
+    ++sz_;
+    return iterator(node);
+  }
+  void push_back(reference value) { insert(end(), value); }
+  void push_front(reference value) { insert(begin(), value); }
+
+  iterator erase(const_iterator pos) {
+    BaseNode* next = pos.node_ptr_->next;
+    unlink(pos.node_ptr_);
+    --sz_;
+    return iterator(next);
+  }
+  // Unlinks an object that is known to be in this list.
+  void erase(reference value) { erase(iterator_to(value)); }
+  void pop_back() { erase(--end()); }
+  void pop_front() { erase(begin()); }
+
+  // Unlinks all the objects; none of them is destroyed.
+  void clear() {
+    BaseNode* node = fake_node_.next;
+    while (node != &fake_node_) {
+      BaseNode* next = node->next;
+      node->prev = node->next = nullptr;
+      node = next;
+    }
+    fake_node_ = {&fake_node_, &fake_node_};
+    sz_ = 0;
+  }
+
+  void splice(const_iterator pos, IntrusiveList& other) {
+    if (&other == this || other.empty()) {
+      return;
+    }
+    BaseNode* first = other.fake_node_.next;
+    BaseNode* last = other.fake_node_.prev;
+    BaseNode* next = pos.node_ptr_;
+    first->prev = next->prev;
+    last->next = next;
+    next->prev->next = first;
+    next->prev = last;
+    sz_ += other.sz_;
+    other.fake_node_ = {&other.fake_node_, &other.fake_node_};
+    other.sz_ = 0;
+  }
+};
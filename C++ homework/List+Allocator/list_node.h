@@ -0,0 +1,13 @@
+#pragma once
+
+// Links of a node in a ring-shaped doubly-linked list. List derives its
+// value-carrying nodes from it and IntrusiveListHook embeds it into user
+// objects, so both containers splice and relink the same structure.
+// A default-constructed node is unlinked.
+struct ListBaseNode {
+  ListBaseNode* prev = nullptr;
+  ListBaseNode* next = nullptr;
+  ListBaseNode() = default;
+  ListBaseNode(ListBaseNode* prev, ListBaseNode* next)
+      : prev(prev), next(next) {}
+};
@@ -0,0 +1,85 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <list>
+#include <random>
+#include <utility>
+
+#include "stackallocator.h"
+
+// List against std::list on the node-relinking algorithms. Every case builds
+// its input outside of the measured region.
+
+constexpr int kSize = 1'000'000;
+constexpr int kRounds = 3;
+
+volatile size_t sink = 0;
+
+template <typename Container>
+Container Random(int size, unsigned seed) {
+  std::mt19937 g(seed);
+  Container c;
+  for (int i = 0; i < size; ++i) {
+    c.push_back(g() % kSize);
+  }
+  return c;
+}
+
+template <typename Container, typename Prepare, typename Body>
+double Measure(Prepare prepare, Body body) {
+  double best = 1e9;
+  for (int round = 0; round < kRounds; ++round) {
+    auto input = prepare();
+    auto start = std::chrono::steady_clock::now();
+    body(input);
+    auto finish = std::chrono::steady_clock::now();
+    sink = input.first.size();
+    std::chrono::duration<double, std::milli> elapsed = finish - start;
+    best = std::min(best, elapsed.count());
+  }
+  return best;
+}
+
+template <typename Container>
+void RunAll(const char* name) {
+  auto two_random = [] {
+    return std::make_pair(Random<Container>(kSize, 1),
+                          Random<Container>(kSize, 2));
+  };
+  auto two_sorted = [two_random] {
+    auto input = two_random();
+    input.first.sort();
+    input.second.sort();
+    return input;
+  };
+
+  double sort = Measure<Container>(two_random,
+                                   [](auto& input) { input.first.sort(); });
+  double merge = Measure<Container>(
+      two_sorted, [](auto& input) { input.first.merge(input.second); });
+  double splice = Measure<Container>(two_random, [](auto& input) {
+    for (int i = 0; i < kSize / 2; ++i) {
+      input.first.splice(input.first.begin(), input.second,
+                         input.second.begin());
+    }
+  });
+  double reverse = Measure<Container>(
+      two_random, [](auto& input) { input.first.reverse(); });
+  double unique = Measure<Container>(
+      two_sorted, [](auto& input) { input.first.unique(); });
+  double remove_if = Measure<Container>(two_random, [](auto& input) {
+    input.first.remove_if([](int x) { return x % 3 == 0; });
+  });
+  std::printf("%-10s %10.1f %10.1f %10.1f %10.1f %10.1f %10.1f\n", name, sort,
+              merge, splice, reverse, unique, remove_if);
+}
+
+int main() {
+  std::printf("%-10s %10s %10s %10s %10s %10s %10s\n", "container", "sort",
+              "merge", "splice", "reverse", "unique", "remove_if");
+  RunAll<List<int>>("List");
+  RunAll<std::list<int>>("std::list");
+  std::printf("(best of %d rounds in ms, %d elements per list)\n", kRounds,
+              kSize);
+}
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <new>
+
+// Runtime interface behind PolymorphicAllocator: containers that differ only
+// in where their memory comes from share one type.
+class MemoryResource {
+ public:
+  virtual ~MemoryResource() = default;
+
+  void* allocate(size_t bytes, size_t alignment = alignof(std::max_align_t)) {
+    return do_allocate(bytes, alignment);
+  }
+  void deallocate(void* ptr, size_t bytes,
+                  size_t alignment = alignof(std::max_align_t)) {
+    do_deallocate(ptr, bytes, alignment);
+  }
+  bool is_equal(const MemoryResource& another) const noexcept {
+    return do_is_equal(another);
+  }
+
+ private:
+  virtual void* do_allocate(size_t bytes, size_t alignment) = 0;
+  virtual void do_deallocate(void* ptr, size_t bytes, size_t alignment) = 0;
+  virtual bool do_is_equal(const MemoryResource& another) const noexcept {
+    return this == &another;
+  }
+};
+
+class HeapResource : public MemoryResource {
+ private:
+  void* do_allocate(size_t bytes, size_t alignment) override {
+    return ::operator new(bytes, std::align_val_t(alignment));
+  }
+  void do_deallocate(void* ptr, size_t bytes, size_t alignment) override {
+    ::operator delete(ptr, bytes, std::align_val_t(alignment));
+  }
+  bool do_is_equal(const MemoryResource& another) const noexcept override {
+    return dynamic_cast<const HeapResource*>(&another) != nullptr;
+  }
+};
+
+inline MemoryResource* heap_resource() {
+  static HeapResource resource;
+  return &resource;
+}
+
+// Keeps one free list per size class and refills an empty one with a chunk
+// of blocks_per_chunk_ blocks from the upstream. Requests above
+// max_small_size_ bytes go to the upstream directly. Chunks are returned to
+// the upstream only when the pool is destroyed.
+class PoolResource : public MemoryResource {
+ public:
+  explicit PoolResource(MemoryResource* upstream = heap_resource())
+      : upstream_(upstream) {}
+  PoolResource(const PoolResource&) = delete;
+  PoolResource& operator=(const PoolResource&) = delete;
+  ~PoolResource() override {
+    while (chunks_ != nullptr) {
+      Chunk* next = chunks_->next;
+      upstream_->deallocate(chunks_, chunks_->size, alignof(Chunk));
+      chunks_ = next;
+    }
+  }
+
+  MemoryResource* upstream() const { return upstream_; }
+
+ private:
+  struct FreeBlock {
+    FreeBlock* next;
+  };
+  struct alignas(std::max_align_t) Chunk {
+    Chunk* next;
+    size_t size;
+  };
+  static const size_t granule_ = alignof(std::max_align_t);
+  static const size_t max_small_size_ = 512;
+  static const size_t blocks_per_chunk_ = 64;
+
+  static size_t block_size(size_t bytes) {
+    return std::max<size_t>((bytes + granule_ - 1) / granule_, 1) * granule_;
+  }
+
+  void* do_allocate(size_t bytes, size_t alignment) override {
+    if (bytes > max_small_size_ || alignment > granule_) {
+      return upstream_->allocate(bytes, alignment);
+    }
+    bytes = block_size(bytes);
+    FreeBlock*& head = free_lists_[bytes / granule_ - 1];
+    if (head == nullptr) {
+      size_t size = sizeof(Chunk) + bytes * blocks_per_chunk_;
+      chunks_ = new (upstream_->allocate(size, alignof(Chunk)))
+          Chunk{chunks_, size};
+      char* block = reinterpret_cast<char*>(chunks_ + 1);
+      for (size_t i = 0; i < blocks_per_chunk_; ++i, block += bytes) {
+        head = new (block) FreeBlock{head};
+      }
+    }
+    void* result = head;
+    head = head->next;
+    return result;
+  }
+
+  void do_deallocate(void* ptr, size_t bytes, size_t alignment) override {
+    if (bytes > max_small_size_ || alignment > granule_) {
+      upstream_->deallocate(ptr, bytes, alignment);
+      return;
+    }
+    bytes = block_size(bytes);
+    FreeBlock*& head = free_lists_[bytes / granule_ - 1];
+    head = new (ptr) FreeBlock{head};
+  }
+
+  MemoryResource* upstream_;
+  Chunk* chunks_ = nullptr;
+  FreeBlock* free_lists_[max_small_size_ / granule_] = {};
+};
+
+template <typename T>
+class PolymorphicAllocator {
+ public:
+  using value_type = T;
+
+  PolymorphicAllocator() noexcept : resource_(heap_resource()) {}
+  PolymorphicAllocator(MemoryResource* resource) noexcept
+      : resource_(resource) {}
+  template <typename U>
+  PolymorphicAllocator(const PolymorphicAllocator<U>& another) noexcept
+      : resource_(another.resource()) {}
+
+  T* allocate(size_t n) {
+    return static_cast<T*>(resource_->allocate(n * sizeof(T), alignof(T)));
+  }
+  void deallocate(T* ptr, size_t n) {
+    resource_->deallocate(ptr, n * sizeof(T), alignof(T));
+  }
+
+  MemoryResource* resource() const { return resource_; }
+
+  template <typename U>
+  bool operator==(const PolymorphicAllocator<U>& another) const {
+    return resource_ == another.resource() ||
+           resource_->is_equal(*another.resource());
+  }
+  template <typename U>
+  bool operator!=(const PolymorphicAllocator<U>& another) const {
+    return !(*this == another);
+  }
+
+ private:
+  MemoryResource* resource_;
+};
@@ -7,15 +7,21 @@
 #include <fstream>
 #include <iostream>
 #include <list>
+#include <random>
 #include <memory>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <thread>
 #include <type_traits>
 #include <vector>
 
 //#include "stackallocator.h"
 #include "nm_alloc.h"
+#include "concurrent_storage.h"
+#include "intrusive_list.h"
+#include "unrolled_list.h"
+#include "../SmartPointers/smart_pointers.h"
 // #include "list.h"
 
 // template<typename T, typename Alloc = std::allocator<T>>
@@ -406,6 +412,635 @@ void TestWhimsicalAllocator() {
   }
 }
 
+void TestMemoryReuse() {
+  StackStorage<4096> storage;
+  StackAllocator<int, 4096> alloc(storage);
+
+  List<int, StackAllocator<int, 4096>> lst(alloc);
+  for (int i = 0; i < 50; ++i) {
+    lst.push_back(i);
+  }
+  for (int i = 50; i < 1'000'000; ++i) {
+    lst.push_back(i);
+    lst.pop_front();
+    if (i % 7 == 0) {
+      lst.insert(std::next(lst.begin(), 25), i);
+      lst.erase(std::next(lst.begin(), 25));
+    }
+  }
+  assert(lst.size() == 50);
+  assert(*lst.begin() == 999'950);
+  assert(*lst.rbegin() == 999'999);
+
+  auto* big = alloc.allocate(500);
+  alloc.deallocate(big, 500);
+  assert(alloc.allocate(500) == big);
+}
+
+void TestArenaOverflow() {
+  {
+    StackStorage<1024> storage;
+    StackAllocator<int, 1024> alloc(storage);
+    List<int, StackAllocator<int, 1024>> lst(alloc);
+    bool thrown = false;
+    try {
+      for (int i = 0; i < 1'000; ++i) {
+        lst.push_back(i);
+      }
+    } catch (const std::bad_alloc&) {
+      thrown = true;
+    }
+    assert(thrown);
+    assert(lst.size() > 0 && *lst.rbegin() == static_cast<int>(lst.size()) - 1);
+  }
+
+  StackStorage<1024> storage(StorageOverflow::kChainBlocks);
+  StackAllocator<int, 1024> alloc(storage);
+  List<int, StackAllocator<int, 1024>> lst(alloc);
+  for (int i = 0; i < 100'000; ++i) {
+    lst.push_back(i);
+  }
+  assert(lst.size() == 100'000 && *lst.rbegin() == 99'999);
+
+  StackAllocator<long double, 1024> ldalloc(alloc);
+  auto* big = ldalloc.allocate(100'000);
+  assert(reinterpret_cast<uintptr_t>(big) % alignof(long double) == 0);
+  big[99'999] = 1.0;
+}
+
+// Records the size of every block a storage chains.
+class BlockSizeRecorder : public MemoryResource {
+ public:
+  std::vector<size_t> sizes;
+
+ private:
+  void* do_allocate(size_t bytes, size_t alignment) override {
+    sizes.push_back(bytes);
+    return heap_resource()->allocate(bytes, alignment);
+  }
+  void do_deallocate(void* ptr, size_t bytes, size_t alignment) override {
+    heap_resource()->deallocate(ptr, bytes, alignment);
+  }
+};
+
+void TestChainedBlockSizes() {
+  BlockSizeRecorder recorder;
+  {
+    // 2 * 16 is below the minimum block size.
+    StackStorage<16> storage(StorageOverflow::kChainBlocks, &recorder);
+    for (int i = 0; i < 300; ++i) {
+      storage.allocate(1, 8, 8);
+    }
+  }
+  assert(recorder.sizes.size() >= 3);
+  assert(recorder.sizes[0] == 1024 && recorder.sizes[1] == 2048 &&
+         recorder.sizes[2] == 4096);
+
+  recorder.sizes.clear();
+  {
+    StackStorage<4096> storage(StorageOverflow::kChainBlocks, &recorder);
+    storage.allocate(4096 + 1, 1, 1);
+  }
+  assert(recorder.sizes.size() == 1 && recorder.sizes[0] == 2 * 4096);
+}
+
+void TestMemoryResources() {
+  StackResource<1024> stack(StorageOverflow::kChainBlocks);
+  PoolResource pool;
+  PoolResource pool_over_stack(&stack);
+  std::vector<MemoryResource*> resources = {heap_resource(), &stack, &pool,
+                                            &pool_over_stack};
+
+  for (MemoryResource* resource : resources) {
+    PolymorphicAllocator<int> alloc(resource);
+    List<int, PolymorphicAllocator<int>> lst(alloc);
+    for (int i = 0; i < 10'000; ++i) {
+      lst.push_back(i);
+      lst.push_front(-i);
+    }
+    for (int i = 0; i < 5'000; ++i) {
+      lst.pop_back();
+    }
+    assert(lst.size() == 15'000 && *lst.rbegin() == 4'999);
+    assert(lst.get_allocator().resource() == resource);
+
+    std::deque<std::string, PolymorphicAllocator<std::string>> d(alloc);
+    for (int i = 0; i < 1'000; ++i) {
+      d.push_back(std::to_string(i));
+    }
+    assert(d[999] == "999");
+
+    PolymorphicAllocator<long double> ldalloc(alloc);
+    auto* pld = ldalloc.allocate(3);
+    assert(reinterpret_cast<uintptr_t>(pld) % alignof(long double) == 0);
+    ldalloc.deallocate(pld, 3);
+  }
+
+  // SharedPtr takes its control block and object from the resource.
+  BlockSizeRecorder recorder;
+  {
+    SharedPtr<std::string> shared = allocateShared<std::string>(
+        PolymorphicAllocator<std::string>(&recorder), 5, 'x');
+    WeakPtr<std::string> weak = shared;
+    assert(*shared == "xxxxx" && recorder.sizes.size() == 1);
+    shared.reset();
+    assert(weak.expired());
+  }
+  SharedPtr<int> from_pool =
+      allocateShared<int>(PolymorphicAllocator<int>(&pool), 42);
+  assert(*from_pool == 42);
+
+  PolymorphicAllocator<int> heap;
+  PolymorphicAllocator<char> other_heap(heap_resource());
+  assert(heap == other_heap);
+  assert(PolymorphicAllocator<int>(&pool) != heap);
+}
+
+template <typename Storage, size_t N>
+void TestConcurrentStorage() {
+  static Storage storage;
+  using Alloc = StackAllocator<int, N, Storage>;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 8; ++t) {
+    threads.emplace_back([t] {
+      List<int, Alloc> lst{Alloc(storage)};
+      for (int i = 0; i < 20'000; ++i) {
+        lst.push_back(t * 20'000 + i);
+      }
+      int expected = t * 20'000;
+      for (int value : lst) {
+        assert(value == expected++);
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+}
+
+template <typename T, typename Alloc, typename Make>
+void CheckUnrolledList(Alloc alloc, Make make) {
+  UnrolledList<T, Alloc> lst(alloc);
+  std::list<T> expected;
+  std::mt19937 g(38);
+  for (int i = 0; i < 20'000; ++i) {
+    size_t position = expected.empty() ? 0 : g() % (expected.size() + 1);
+    switch (g() % 6) {
+      case 0:
+        lst.push_back(make(i));
+        expected.push_back(make(i));
+        break;
+      case 1:
+        lst.push_front(make(i));
+        expected.push_front(make(i));
+        break;
+      case 2:
+      case 3: {
+        auto it = lst.insert(std::next(lst.begin(), position), make(i));
+        assert(*it == make(i));
+        expected.insert(std::next(expected.begin(), position), make(i));
+        break;
+      }
+      case 4:
+        if (!expected.empty()) {
+          position %= expected.size();
+          lst.erase(std::next(lst.begin(), position));
+          expected.erase(std::next(expected.begin(), position));
+        }
+        break;
+      default:
+        if (!expected.empty()) {
+          lst.pop_back();
+          expected.pop_back();
+        }
+    }
+  }
+  assert(lst.size() == expected.size());
+  assert(std::equal(lst.begin(), lst.end(), expected.begin(), expected.end()));
+  assert(std::equal(lst.rbegin(), lst.rend(), expected.rbegin(),
+                    expected.rend()));
+
+  UnrolledList<T, Alloc> copy = lst;
+  while (lst.size() > 0) {
+    lst.pop_front();
+  }
+  lst = copy;
+  assert(std::equal(lst.begin(), lst.end(), expected.begin(), expected.end()));
+
+  // Moves hand the nodes over instead of copying the values.
+  const T* first = &*copy.begin();
+  UnrolledList<T, Alloc> moved = std::move(copy);
+  assert(copy.size() == 0 && copy.begin() == copy.end());
+  assert(&*moved.begin() == first && moved.size() == expected.size());
+  lst = std::move(moved);
+  assert(&*lst.begin() == first && moved.size() == 0);
+  assert(std::equal(lst.begin(), lst.end(), expected.begin(), expected.end()));
+  moved = std::move(lst);
+  moved.push_back(make(0));
+  assert(moved.size() == expected.size() + 1 && lst.size() == 0);
+
+  UnrolledList<T, Alloc> defaults(1'000, alloc);
+  assert(defaults.size() == 1'000);
+  assert(std::all_of(defaults.begin(), defaults.end(),
+                     [](const T& value) { return value == T(); }));
+  UnrolledList<T, Alloc> filled(1'000, make(7), alloc);
+  assert(filled.size() == 1'000 && *filled.rbegin() == make(7));
+  assert(std::count(filled.begin(), filled.end(), make(7)) == 1'000);
+}
+
+void TestUnrolledList() {
+  CheckUnrolledList<int>(std::allocator<int>(), [](int i) { return i; });
+  CheckUnrolledList<std::string>(
+      std::allocator<std::string>(),
+      [](int i) { return std::string(30, 'a' + i % 26); });
+  {
+    StackStorage<100'000> storage;
+    StackAllocator<int, 100'000> alloc(storage);
+    CheckUnrolledList<int>(alloc, [](int i) { return i; });
+  }
+
+  List<int> lst;
+  UnrolledList<int> unrolled;
+  for (int i = 0; i < 1'000'000; ++i) {
+    lst.push_back(i);
+    unrolled.push_back(i);
+  }
+  using namespace std::chrono;
+  long long sum = 0;
+  auto start = high_resolution_clock::now();
+  for (int value : lst) {
+    sum += value;
+  }
+  auto middle = high_resolution_clock::now();
+  for (int value : unrolled) {
+    sum -= value;
+  }
+  auto finish = high_resolution_clock::now();
+  assert(sum == 0);
+  std::cerr << " Iterating 1M ints: List "
+            << duration_cast<microseconds>(middle - start).count()
+            << " us, UnrolledList "
+            << duration_cast<microseconds>(finish - middle).count() << " us"
+            << std::endl;
+}
+
+void TestListAlgorithms() {
+  std::mt19937 g(39);
+  List<int> lst;
+  std::list<int> expected;
+  for (int i = 0; i < 50'000; ++i) {
+    int value = g() % 1'000;
+    lst.push_back(value);
+    expected.push_back(value);
+  }
+  auto same = [&] {
+    return lst.size() == expected.size() &&
+           std::equal(lst.begin(), lst.end(), expected.begin(),
+                      expected.end()) &&
+           std::equal(lst.rbegin(), lst.rend(), expected.rbegin(),
+                      expected.rend());
+  };
+
+  lst.sort();
+  expected.sort();
+  assert(same());
+  lst.reverse();
+  expected.reverse();
+  assert(same());
+  lst.sort(std::greater<>());
+  expected.sort(std::greater<>());
+  assert(same());
+  assert(lst.unique() == 49'000);
+  expected.unique();
+  assert(same());
+
+  List<int> other;
+  std::list<int> expected_other;
+  for (int i = 0; i < 3'000; i += 3) {
+    other.push_front(i);
+    expected_other.push_front(i);
+  }
+  lst.merge(other, std::greater<>());
+  expected.merge(expected_other, std::greater<>());
+  assert(same() && other.size() == 0);
+
+  std::vector<std::pair<int, int>> pairs;
+  List<std::pair<int, int>> stable;
+  for (int i = 0; i < 10'000; ++i) {
+    pairs.emplace_back(g() % 10, i);
+    stable.push_back(pairs.back());
+  }
+  auto by_first = [](const auto& x, const auto& y) {
+    return x.first < y.first;
+  };
+  stable.sort(by_first);
+  std::stable_sort(pairs.begin(), pairs.end(), by_first);
+  assert(std::equal(stable.begin(), stable.end(), pairs.begin(), pairs.end()));
+
+  assert(lst.remove_if([](int x) { return x % 2 == 0; }) ==
+         static_cast<size_t>(std::count_if(expected.begin(), expected.end(),
+                                           [](int x) { return x % 2 == 0; })));
+  expected.remove_if([](int x) { return x % 2 == 0; });
+  assert(same());
+
+  List<int> donor;
+  std::list<int> expected_donor;
+  for (int i = 0; i < 100; ++i) {
+    donor.push_back(-i);
+    expected_donor.push_back(-i);
+  }
+  lst.splice(std::next(lst.begin(), 10), donor, std::next(donor.begin(), 5));
+  expected.splice(std::next(expected.begin(), 10), expected_donor,
+                  std::next(expected_donor.begin(), 5));
+  lst.splice(lst.begin(), donor, std::next(donor.begin(), 20),
+             std::prev(donor.end(), 20));
+  expected.splice(expected.begin(), expected_donor,
+                  std::next(expected_donor.begin(), 20),
+                  std::prev(expected_donor.end(), 20));
+  lst.splice(lst.end(), donor);
+  expected.splice(expected.end(), expected_donor);
+  assert(same() && donor.size() == 0);
+  lst.splice(lst.begin(), lst, std::prev(lst.end()));
+  expected.splice(expected.begin(), expected, std::prev(expected.end()));
+  assert(same());
+  // Splicing an element in front of itself or of its successor does
+  // nothing.
+  auto third = std::next(lst.begin(), 2);
+  lst.splice(third, lst, third);
+  lst.splice(std::next(third), lst, third);
+  assert(same());
+
+  StackStorage<100'000> first_storage;
+  StackStorage<100'000> second_storage;
+  using Alloc = StackAllocator<int, 100'000>;
+  List<int, Alloc> first{Alloc(first_storage)};
+  List<int, Alloc> second{Alloc(second_storage)};
+  for (int i = 0; i < 100; ++i) {
+    first.push_back(i);
+    second.push_back(100 + i);
+  }
+  first.splice(first.end(), second);
+  assert(first.size() == 200 && second.size() == 0);
+  int value = 0;
+  for (int x : first) {
+    assert(x == value++);
+  }
+}
+
+struct CopyCounter {
+  static inline int copies = 0;
+  std::string text;
+  int number = 0;
+  CopyCounter(std::string text, int number)
+      : text(std::move(text)), number(number) {}
+  CopyCounter(const CopyCounter& another)
+      : text(another.text), number(another.number) {
+    ++copies;
+  }
+  CopyCounter(CopyCounter&&) = default;
+};
+
+void TestEmplaceAndMove() {
+  std::string long_text(100, 'x');
+  List<CopyCounter> lst;
+  lst.emplace_back(long_text, 1);
+  lst.emplace_front(long_text, 0);
+  auto it = lst.emplace(std::next(lst.begin()), long_text, 5);
+  assert(it->number == 5);
+  lst.push_back(CopyCounter(long_text, 2));
+  lst.insert(lst.end(), CopyCounter(long_text, 3));
+  assert(CopyCounter::copies == 0 && lst.size() == 5);
+
+  List<std::string> strings;
+  std::string moved = long_text;
+  const char* data = moved.data();
+  strings.push_back(std::move(moved));
+  assert(strings.begin()->data() == data);
+
+  List<std::string> stolen = std::move(strings);
+  assert(strings.size() == 0 && stolen.size() == 1);
+  assert(stolen.begin()->data() == data);
+  strings = std::move(stolen);
+  assert(stolen.size() == 0 && strings.begin()->data() == data);
+  strings = std::move(strings);
+  assert(strings.size() == 1);
+
+  StackStorage<100'000> first_storage;
+  StackStorage<100'000> second_storage;
+  using Alloc = StackAllocator<std::string, 100'000>;
+  List<std::string, Alloc> first{Alloc(first_storage)};
+  List<std::string, Alloc> second{Alloc(second_storage)};
+  for (int i = 0; i < 100; ++i) {
+    second.push_back(std::string(50, 'a' + i % 26));
+  }
+  first = std::move(second);
+  assert(first.size() == 100);
+  assert(first.get_allocator() != second.get_allocator());
+  assert(*first.rbegin() == std::string(50, 'a' + 99 % 26));
+
+  PoolResource pool;
+  using Poly = PolymorphicAllocator<std::string>;
+  List<std::string, Poly> pooled{Poly(&pool)};
+  List<std::string, Poly> heap;
+  pooled.emplace_back(long_text);
+  heap = std::move(pooled);
+  assert(heap.size() == 1);
+  assert(heap.get_allocator().resource() == heap_resource());
+}
+
+void TestBatchedConstruction() {
+  StackStorage<1'000'000> storage;
+  using Alloc = StackAllocator<int, 1'000'000>;
+  {
+    // Scatter a few free blocks first: a batch must not be assembled
+    // from them.
+    List<int, Alloc> scattered{Alloc(storage)};
+    for (int i = 0; i < 10; ++i) {
+      scattered.push_back(i);
+    }
+  }
+  List<int, Alloc> lst(1000, 7, Alloc(storage));
+  assert(lst.size() == 1000);
+  std::vector<const int*> addresses;
+  for (const int& value : lst) {
+    assert(value == 7);
+    addresses.push_back(&value);
+  }
+  std::ptrdiff_t stride = addresses[1] - addresses[0];
+  assert(stride > 0);
+  for (size_t i = 1; i < addresses.size(); ++i) {
+    assert(addresses[i] - addresses[i - 1] == stride);
+  }
+  List<int, Alloc> copy = lst;
+  assert(copy.size() == 1000 && *copy.begin() == 7);
+  assert(&*std::next(copy.begin()) - &*copy.begin() == stride);
+  List<int, Alloc> defaults(3, Alloc(storage));
+  assert(defaults.size() == 3 && *defaults.rbegin() == 0);
+
+  // A throwing copy hands its whole batch back to the storage, so the next
+  // node is carved from the last slot of that batch.
+  using ThrowingAlloc = StackAllocator<ThrowingAccountant, 1'000'000>;
+  Accountant::reset();
+  List<ThrowingAccountant, ThrowingAlloc> source(3, ThrowingAlloc(storage));
+  ThrowingAccountant::need_throw = true;
+  try {
+    List<ThrowingAccountant, ThrowingAlloc> broken = source;
+    assert(false);
+  } catch (...) {
+  }
+  ThrowingAccountant::need_throw = false;
+  assert(Accountant::ctor_calls == Accountant::dtor_calls + 3);
+  auto address = [](const ThrowingAccountant& value) {
+    return reinterpret_cast<const char*>(&value);
+  };
+  const char* first = address(*source.begin());
+  std::ptrdiff_t node_stride = address(*std::next(source.begin())) - first;
+  List<ThrowingAccountant, ThrowingAlloc> reused(1, ThrowingAlloc(storage));
+  assert(address(*reused.begin()) - first == 5 * node_stride);
+}
+
+struct ConnectionTag;
+
+struct Connection : public IntrusiveListHook<>,
+                    public IntrusiveListHook<ConnectionTag,
+                                             HookMode::kAutoUnlink> {
+  int id;
+  explicit Connection(int id) : id(id) {}
+};
+
+void TestIntrusiveList() {
+  using AutoHook = IntrusiveListHook<ConnectionTag, HookMode::kAutoUnlink>;
+  std::vector<Connection> connections;
+  for (int i = 0; i < 10; ++i) {
+    connections.emplace_back(i);
+  }
+  IntrusiveList<Connection> timers;
+  for (Connection& connection : connections) {
+    timers.push_back(connection);
+  }
+  assert(timers.size() == 10 && timers.front().id == 0);
+  assert(&timers.back() == &connections.back());
+
+  timers.erase(connections[4]);
+  assert(timers.size() == 9);
+  assert(!connections[4].IntrusiveListHook<>::is_linked());
+  auto it = timers.erase(timers.iterator_to(connections[5]));
+  assert(it->id == 6);
+  timers.insert(it, connections[4]);
+  std::vector<int> ids;
+  for (const Connection& connection : timers) {
+    ids.push_back(connection.id);
+  }
+  assert((ids == std::vector<int>{0, 1, 2, 3, 4, 6, 7, 8, 9}));
+  assert(timers.rbegin()->id == 9);
+
+  IntrusiveList<Connection> moved = std::move(timers);
+  assert(timers.empty() && moved.size() == 9);
+  timers.push_back(connections[5]);
+  timers.splice(timers.begin(), moved);
+  assert(moved.empty() && timers.size() == 10 && timers.back().id == 5);
+
+  {
+    IntrusiveList<Connection, AutoHook> open;
+    Connection copy = connections[0];
+    assert(!copy.IntrusiveListHook<>::is_linked());
+    std::vector<Connection> extra(3, Connection(100));
+    for (Connection& connection : extra) {
+      open.push_back(connection);
+    }
+    open.push_back(copy);
+    open.push_front(connections[1]);
+    assert(open.size() == 5);
+    extra.pop_back();
+    assert(open.size() == 4 && open.back().id == 0);
+    connections[1].AutoHook::unlink();
+    assert(open.size() == 3 && open.front().id == 100);
+  }
+  assert(!connections[1].AutoHook::is_linked());
+  timers.clear();
+  assert(timers.empty() && !connections[0].IntrusiveListHook<>::is_linked());
+}
+
+void TestStorageStats() {
+  // Without STACK_STORAGE_STATS the counters take no room in the storage.
+  static_assert(std::is_empty_v<StorageInstrumentation<false>>);
+  StackStorage<10'000> storage;
+  size_t available = storage.available();
+  StackAllocator<char, 10'000> alloc(storage);
+  {
+    List<int, StackAllocator<int, 10'000>> lst(alloc);
+    lst.push_back(1);
+    lst.push_back(2);
+    char* chars = alloc.allocate(1000);
+    alloc.deallocate(chars, 1000);
+    assert(storage.available() < available);
+    lst.pop_back();
+    lst.push_back(3);
+  }
+  StackAllocator<std::max_align_t, 10'000> big(storage);
+  try {
+    big.allocate(10'000);
+    assert(false);
+  } catch (const std::bad_alloc&) {
+  }
+  const StorageStats& stats = storage.stats();
+  if constexpr (kStorageStats) {
+    assert(stats.allocations == 4 && stats.free_list_hits == 1);
+    assert(stats.failed_allocations == 1 && stats.bytes_in_use == 0);
+    assert(stats.high_water >= 1000 && stats.histogram[7] == 1);
+  } else {
+    assert(stats.allocations == 0 && stats.high_water == 0);
+  }
+}
+
+void TestArenaScope() {
+  StackStorage<100'000> storage;
+  using Alloc = StackAllocator<int, 100'000>;
+  List<int, Alloc> long_lived{Alloc(storage)};
+  for (int i = 0; i < 10; ++i) {
+    long_lived.push_back(i);
+  }
+  const int* freed = &*long_lived.begin();
+  long_lived.pop_front();
+  size_t available = storage.available();
+  {
+    ArenaScope scope(storage);
+    List<int, Alloc> scratch{Alloc(storage)};
+    for (int i = 0; i < 1000; ++i) {
+      scratch.push_back(i);
+    }
+    assert(storage.available() < available);
+  }
+  assert(storage.available() == available);
+  assert(long_lived.size() == 9 && *long_lived.rbegin() == 9);
+
+  StackAllocator<int, 100'000> raw(storage);
+  auto marker = storage.mark();
+  for (int i = 0; i < 100; ++i) {
+    std::ignore = raw.allocate(100);  // Never deallocated.
+  }
+  storage.rewind(marker);
+  assert(storage.available() == available);
+  // The block freed by pop_front before the marks is still reused.
+  long_lived.push_front(-1);
+  assert(&*long_lived.begin() == freed);
+
+  StackStorage<1'000> chained(StorageOverflow::kChainBlocks);
+  StackAllocator<char, 1'000> chars(chained);
+  std::ignore = chars.allocate(600);
+  size_t chained_available = chained.available();
+  {
+    ArenaScope outer(chained);
+    std::ignore = chars.allocate(100'000);
+    {
+      ArenaScope inner(chained);
+      std::ignore = chars.allocate(1'000'000);
+    }
+    std::ignore = chars.allocate(10);
+  }
+  assert(chained.available() == chained_available);
+}
+
 template <class List>
 int ListPerformanceTest(List&& l) {
   using namespace std::chrono;
@@ -630,6 +1265,52 @@ int main() {
 
   std::cerr << "Test 7 (Allocator Awareness) passed." << std::endl;
 
+  TestMemoryReuse();
+
+  std::cerr << "Test 8 (MemoryReuse) passed." << std::endl;
+
+  TestArenaOverflow();
+  TestChainedBlockSizes();
+
+  std::cerr << "Test 9 (ArenaOverflow) passed." << std::endl;
+
+  TestMemoryResources();
+
+  std::cerr << "Test 10 (MemoryResources) passed." << std::endl;
+
+  TestConcurrentStorage<AtomicStackStorage<20'000'000>, 20'000'000>();
+  TestConcurrentStorage<ThreadCachedStackStorage<20'000'000>, 20'000'000>();
+
+  std::cerr << "Test 11 (ConcurrentStorage) passed." << std::endl;
+
+  TestUnrolledList();
+
+  std::cerr << "Test 12 (UnrolledList) passed." << std::endl;
+
+  TestListAlgorithms();
+
+  std::cerr << "Test 13 (ListAlgorithms) passed." << std::endl;
+
+  TestEmplaceAndMove();
+
+  std::cerr << "Test 14 (EmplaceAndMove) passed." << std::endl;
+
+  TestBatchedConstruction();
+
+  std::cerr << "Test 15 (BatchedConstruction) passed." << std::endl;
+
+  TestIntrusiveList();
+
+  std::cerr << "Test 16 (IntrusiveList) passed." << std::endl;
+
+  TestStorageStats();
+
+  std::cerr << "Test 17 (StorageStats) passed." << std::endl;
+
+  TestArenaScope();
+
+  std::cerr << "Test 18 (ArenaScope) passed." << std::endl;
+
   std::cerr << "Starting performance test. First, let's test performance of "
                "different allocators with std::list."
             << std::endl;
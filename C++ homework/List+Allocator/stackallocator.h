@@ -1,34 +1,338 @@
+#pragma once
+
 #include <algorithm>
 #include <cassert>
 #include <cstddef>
+#include <cstdint>
 #include <cstring>
+#include <functional>
 #include <iostream>
+#include <iterator>
+#include <memory>
+#include <new>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
+#include "list_node.h"
+#include "memory_resource.h"
+
+enum class StorageOverflow { kFail, kChainBlocks };
+
+// STACK_STORAGE_STATS changes the layout of StackStorage, so every
+// translation unit linked into one binary has to agree on it. Mixing them
+// violates the ODR.
+#ifdef STACK_STORAGE_STATS
+inline constexpr bool kStorageStats = true;
+#else
+inline constexpr bool kStorageStats = false;
+#endif
+
+// Counters that StackStorage keeps when STACK_STORAGE_STATS is defined.
+// Without it they stay zero and cost nothing.
+struct StorageStats {
+  static constexpr size_t histogram_buckets = 16;
+
+  size_t bytes_in_use = 0;  // Size-class rounded, not yet deallocated.
+  size_t high_water = 0;    // Maximum of bytes_in_use.
+  size_t bytes_carved = 0;  // Taken from the buffer and blocks by bumping.
+  size_t alignment_waste = 0;  // Padding skipped over by std::align.
+  size_t allocations = 0;
+  size_t free_list_hits = 0;
+  size_t failed_allocations = 0;
+  // histogram[i] counts requests of up to 8 << i bytes; the last bucket
+  // also takes all larger ones.
+  size_t histogram[histogram_buckets] = {};
+};
+
+// Called on every allocation and deallocation of a storage, as long as
+// STACK_STORAGE_STATS is defined.
+using StorageTraceHook = void (*)(void* context, const void* ptr,
+                                  size_t bytes, bool allocated);
+
+// What a StackStorage records about itself. The specialisation used without
+// STACK_STORAGE_STATS is empty and takes no room as a base class.
+template <bool Enabled>
+struct StorageInstrumentation {
+  StorageStats stats_;
+  StorageTraceHook trace_hook_ = nullptr;
+  void* trace_context_ = nullptr;
+};
+
+template <>
+struct StorageInstrumentation<false> {};
+
+// Bump allocator over an inline buffer. Freed blocks of up to
+// max_small_size_ bytes go to a free list of their size class and are handed
+// out again by later allocations of the same class, so a container that
+// keeps erasing and inserting nodes stays within a fixed footprint.
+// With StorageOverflow::kChainBlocks an exhausted buffer is followed by
+// blocks of geometrically growing size taken from the upstream resource, all
+// released by the destructor. The first one takes 2 * N bytes, but at least
+// min_block_size_, so that a tiny buffer does not chain tiny blocks.
+// mark() and rewind() release everything allocated in between at once; see
+// ArenaScope.
 template <size_t N>
-class StackStorage {
+class StackStorage : private StorageInstrumentation<kStorageStats> {
+ private:
+  struct Block;
+  struct FreeBlock;
+  static const size_t granule_ = alignof(std::max_align_t);
+  static const size_t max_small_size_ = 512;
+  static constexpr size_t min_block_size_ = 1024;
+
  public:
-  StackStorage() : begin_(buffer_), buffer_(), ptr_(buffer_), size_(N){};
+  // Position of the storage returned by mark(). Blocks freed between mark()
+  // and rewind() that had been allocated before mark() are not reused.
+  class Marker {
+   private:
+    friend class StackStorage;
+    void* ptr;
+    size_t size;
+    Block* blocks;
+    size_t next_block_size;
+    size_t bytes_in_use;
+    FreeBlock* free_lists[max_small_size_ / granule_];
+  };
+
+  explicit StackStorage(StorageOverflow overflow = StorageOverflow::kFail,
+                        MemoryResource* upstream = heap_resource())
+      : begin_(buffer_),
+        buffer_(),
+        ptr_(buffer_),
+        size_(N),
+        overflow_(overflow),
+        upstream_(upstream),
+        next_block_size_(std::max<size_t>(2 * N, min_block_size_)){};
+  ~StackStorage() {
+    while (blocks_ != nullptr) {
+      Block* prev = blocks_->prev;
+      upstream_->deallocate(blocks_, blocks_->size, alignof(Block));
+      blocks_ = prev;
+    }
+  }
   void* allocate(size_t n, size_t sz_of, size_t alignment) {
-    if (std::align(alignment, sz_of * n, ptr_, size_) != nullptr) {
-      void* result = ptr_;
-      ptr_ = (char*)ptr_ + sz_of * n;
-      size_ -= sz_of * n;
-      return result;
+    size_t bytes = sz_of * n;
+    note_request(bytes);
+    if (bytes <= max_small_size_) {
+      bytes = block_size(bytes);
+      FreeBlock*& head = free_lists_[bytes / granule_ - 1];
+      if (head != nullptr &&
+          reinterpret_cast<uintptr_t>(head) % alignment == 0) {
+        void* result = head;
+        head = head->next;
+        note_allocation(result, bytes, 0, true);
+        return result;
+      }
     }
-    return nullptr;
+    size_t size_before = size_;
+    if (std::align(alignment, bytes, ptr_, size_) == nullptr) {
+      if (overflow_ == StorageOverflow::kFail) {
+        note_allocation(nullptr, bytes, 0, false);
+        return nullptr;
+      }
+      add_block(bytes + alignment);
+      size_before = size_;
+      std::align(alignment, bytes, ptr_, size_);
+    }
+    void* result = ptr_;
+    note_allocation(result, bytes, size_before - size_, false);
+    ptr_ = (char*)ptr_ + bytes;
+    size_ -= bytes;
+    return result;
+  }
+  // Carves n blocks for objects of sz_of bytes out of one contiguous region,
+  // stride bytes apart, so that each of them can be deallocated on its own.
+  void* allocate_batch(size_t n, size_t sz_of, size_t alignment,
+                       size_t& stride) {
+    stride = sz_of <= max_small_size_ ? block_size(sz_of) : sz_of;
+    return allocate(n, stride, alignment);
+  }
+  void deallocate(void* ptr, size_t n, size_t sz_of) {
+    size_t bytes = sz_of * n;
+    note_deallocation(ptr, bytes <= max_small_size_ ? block_size(bytes)
+                                                    : bytes);
+    if (bytes > max_small_size_) {
+      if ((char*)ptr + bytes == ptr_) {
+        ptr_ = ptr;
+        size_ += bytes;
+      }
+      return;
+    }
+    bytes = block_size(bytes);
+    FreeBlock*& head = free_lists_[bytes / granule_ - 1];
+    head = new (ptr) FreeBlock{head};
   }
   StackStorage(const StackStorage&) = delete;
 
+  // Sets the free lists aside, so that everything allocated until rewind()
+  // comes from memory that rewind() gives back. Markers must be rewound in
+  // the reverse order of their creation, after the objects allocated since
+  // then are destroyed.
+  Marker mark() {
+    Marker marker;
+    marker.ptr = ptr_;
+    marker.size = size_;
+    marker.blocks = blocks_;
+    marker.next_block_size = next_block_size_;
+    if constexpr (kStorageStats) {
+      marker.bytes_in_use = this->stats_.bytes_in_use;
+    }
+    std::copy(std::begin(free_lists_), std::end(free_lists_),
+              marker.free_lists);
+    std::fill(std::begin(free_lists_), std::end(free_lists_), nullptr);
+    return marker;
+  }
+  void rewind(const Marker& marker) {
+    while (blocks_ != marker.blocks) {
+      Block* prev = blocks_->prev;
+      upstream_->deallocate(blocks_, blocks_->size, alignof(Block));
+      blocks_ = prev;
+    }
+    ptr_ = marker.ptr;
+    size_ = marker.size;
+    next_block_size_ = marker.next_block_size;
+    if constexpr (kStorageStats) {
+      this->stats_.bytes_in_use = marker.bytes_in_use;
+    }
+    std::copy(std::begin(marker.free_lists), std::end(marker.free_lists),
+              free_lists_);
+  }
+
+  // Bytes left for bumping in the buffer, or in the current block once the
+  // storage has started chaining.
+  size_t available() const { return size_; }
+  const StorageStats& stats() const {
+    if constexpr (kStorageStats) {
+      return this->stats_;
+    } else {
+      static const StorageStats zero;
+      return zero;
+    }
+  }
+  void set_trace_hook(StorageTraceHook hook, void* context) {
+    if constexpr (kStorageStats) {
+      this->trace_hook_ = hook;
+      this->trace_context_ = context;
+    }
+  }
+
  private:
+  // The members of StorageInstrumentation are reached through this-> since
+  // they do not exist without STACK_STORAGE_STATS.
+  void note_request(size_t bytes) {
+    if constexpr (kStorageStats) {
+      size_t bucket = 0;
+      while (bucket + 1 < StorageStats::histogram_buckets &&
+             (size_t{8} << bucket) < bytes) {
+        ++bucket;
+      }
+      ++this->stats_.histogram[bucket];
+    }
+  }
+  void note_allocation(void* result, size_t bytes, size_t padding,
+                       bool reused) {
+    if constexpr (kStorageStats) {
+      StorageStats& counters = this->stats_;
+      if (result == nullptr) {
+        ++counters.failed_allocations;
+        return;
+      }
+      ++counters.allocations;
+      counters.bytes_in_use += bytes;
+      counters.high_water = std::max(counters.high_water,
+                                     counters.bytes_in_use);
+      if (reused) {
+        ++counters.free_list_hits;
+      } else {
+        counters.bytes_carved += bytes + padding;
+        counters.alignment_waste += padding;
+      }
+      if (this->trace_hook_ != nullptr) {
+        this->trace_hook_(this->trace_context_, result, bytes, true);
+      }
+    }
+  }
+  void note_deallocation(void* ptr, size_t bytes) {
+    if constexpr (kStorageStats) {
+      this->stats_.bytes_in_use -= bytes;
+      if (this->trace_hook_ != nullptr) {
+        this->trace_hook_(this->trace_context_, ptr, bytes, false);
+      }
+    }
+  }
+
+  struct FreeBlock {
+    FreeBlock* next;
+  };
+
+  static size_t block_size(size_t bytes) {
+    return std::max<size_t>((bytes + granule_ - 1) / granule_, 1) * granule_;
+  }
+
+  struct alignas(std::max_align_t) Block {
+    Block* prev;
+    size_t size;
+  };
+
+  void add_block(size_t bytes) {
+    size_t size = std::max(next_block_size_, sizeof(Block) + bytes);
+    blocks_ = new (upstream_->allocate(size, alignof(Block)))
+        Block{blocks_, size};
+    ptr_ = blocks_ + 1;
+    size_ = size - sizeof(Block);
+    next_block_size_ = 2 * size;
+  }
+
   char* begin_ = nullptr;
   char buffer_[N];
   void* ptr_;
   std::size_t size_;
+  FreeBlock* free_lists_[max_small_size_ / granule_] = {};
+  StorageOverflow overflow_;
+  MemoryResource* upstream_;
+  size_t next_block_size_;
+  Block* blocks_ = nullptr;
+};
+
+// Releases everything allocated from storage during its lifetime.
+template <typename Storage>
+class ArenaScope {
+ public:
+  explicit ArenaScope(Storage& storage)
+      : storage_(storage), marker_(storage.mark()) {}
+  ArenaScope(const ArenaScope&) = delete;
+  ArenaScope& operator=(const ArenaScope&) = delete;
+  ~ArenaScope() { storage_.rewind(marker_); }
+
+ private:
+  Storage& storage_;
+  typename Storage::Marker marker_;
+};
+
+template <size_t N>
+class StackResource : public MemoryResource {
+ public:
+  explicit StackResource(StorageOverflow overflow = StorageOverflow::kFail,
+                         MemoryResource* upstream = heap_resource())
+      : storage_(overflow, upstream) {}
+
+ private:
+  void* do_allocate(size_t bytes, size_t alignment) override {
+    void* result = storage_.allocate(bytes, 1, alignment);
+    if (result == nullptr) {
+      throw std::bad_alloc();
+    }
+    return result;
+  }
+  void do_deallocate(void* ptr, size_t bytes, size_t) override {
+    storage_.deallocate(ptr, bytes, 1);
+  }
+
+  StackStorage<N> storage_;
 };
 
-template <typename T, size_t N>
+template <typename T, size_t N, typename Storage = StackStorage<N>>
 class StackAllocator {
  public:
   using value_type = T;
@@ -41,49 +345,93 @@ class StackAllocator {
 
   template <class U>
   struct rebind {
-    using other = StackAllocator<U, N>;
+    using other = StackAllocator<U, N, Storage>;
   };
   struct propagate_on_container_copy_assignment : std::false_type {};
 
   StackAllocator() : storage_(nullptr){};
-  StackStorage<N>* getStorage() const { return storage_; }
+  Storage* getStorage() const { return storage_; }
 
   template <typename U>
-  constexpr StackAllocator(StackAllocator<U, N> other_alloc) noexcept {
+  constexpr StackAllocator(StackAllocator<U, N, Storage> other_alloc) noexcept {
     storage_ = other_alloc.getStorage();
   }
-  explicit StackAllocator(StackStorage<N>& storage) : storage_(&storage) {}
+  explicit StackAllocator(Storage& storage) : storage_(&storage) {}
   ~StackAllocator() = default;
 
   template <typename U>
-  StackAllocator* operator=(const StackAllocator<U, N>& another) {
+  StackAllocator* operator=(const StackAllocator<U, N, Storage>& another) {
     storage_ = another.storage_;
     return *this;
   }
 
   pointer allocate(size_type n) {
     if (storage_ == nullptr) {
-      return nullptr;
+      throw std::bad_alloc();
     }
     void* result = storage_->allocate(n, sizeof(T), alignof(T));
     if (result == nullptr) {
-      return nullptr;
+      throw std::bad_alloc();
     }
     return reinterpret_cast<T*>(result);
   }
 
+  // Allocates n objects in one contiguous block and passes each of them to
+  // visit in address order. An object for which visit throws, and all the
+  // following ones, are deallocated again.
+  template <typename Visit, typename S = Storage>
+  auto allocate_batch(size_type n, Visit visit)
+      -> decltype(std::declval<S&>().allocate_batch(
+                      n, 0, 0, std::declval<size_t&>()),
+                  void()) {
+    if (storage_ == nullptr) {
+      throw std::bad_alloc();
+    }
+    size_t stride = 0;
+    char* block = static_cast<char*>(
+        storage_->allocate_batch(n, sizeof(T), alignof(T), stride));
+    if (block == nullptr) {
+      throw std::bad_alloc();
+    }
+    size_type i = 0;
+    try {
+      for (; i < n; ++i) {
+        visit(reinterpret_cast<T*>(block + i * stride));
+      }
+    } catch (...) {
+      for (; i < n; ++i) {
+        deallocate(reinterpret_cast<T*>(block + i * stride), 1);
+      }
+      throw;
+    }
+  }
+
   bool operator==(const StackAllocator& another) const {
     return storage_ == another.storage_;
   }
   bool operator!=(const StackAllocator& another) const {
     return storage_ != another.storage_;
   }
-  void deallocate(pointer, size_type) {}
+  void deallocate(pointer ptr, size_type n) {
+    if (storage_ != nullptr) {
+      storage_->deallocate(ptr, n, sizeof(T));
+    }
+  }
 
  private:
-  StackStorage<N>* storage_ = nullptr;
+  Storage* storage_ = nullptr;
 };
 
+template <typename Alloc, typename = void>
+struct HasAllocateBatch : std::false_type {};
+
+template <typename Alloc>
+struct HasAllocateBatch<
+    Alloc, std::void_t<decltype(std::declval<Alloc&>().allocate_batch(
+               size_t(),
+               std::declval<void (*)(typename Alloc::value_type*)>()))>>
+    : std::true_type {};
+
 template <typename T, typename Allocator = std::allocator<T>>
 class List {
  private:
@@ -95,19 +443,12 @@ class List {
   using size_type = std::size_t;
   using difference_type = ptrdiff_t;
 
-  struct BaseNode {
-    BaseNode* prev;
-    BaseNode* next;
-    BaseNode() = default;
-    BaseNode(BaseNode* prev, BaseNode* next) : prev(prev), next(next){};
-    ~BaseNode() = default;
-  };
+  using BaseNode = ListBaseNode;
   struct Node : public BaseNode {
     value_type value;
-    Node() = default;
-    Node(BaseNode* prev, BaseNode* next) : BaseNode(prev, next){};
-    Node(const_reference value, BaseNode* prev, BaseNode* next)
-        : BaseNode(prev, next), value(value) {}
+    template <typename... Args>
+    Node(BaseNode* prev, BaseNode* next, Args&&... args)
+        : BaseNode(prev, next), value(std::forward<Args>(args)...) {}
     ~Node() = default;
   };
 
@@ -116,9 +457,128 @@ class List {
   using NodeAllocTraits =
       typename std::allocator_traits<Allocator>::template rebind_traits<Node>;
 
+  // Points the first and last nodes back at fake_node_ after it was copied
+  // from another list.
+  void adopt_nodes() {
+    if (sz_ == 0) {
+      fake_node_ = {&fake_node_, &fake_node_};
+    } else {
+      fake_node_.next->prev = &fake_node_;
+      fake_node_.prev->next = &fake_node_;
+    }
+  }
+
   void swap(List<T, Allocator>& other) {
+    std::swap(allocator_, other.allocator_);
     std::swap(fake_node_, other.fake_node_);
     std::swap(sz_, other.sz_);
+    adopt_nodes();
+    other.adopt_nodes();
+  }
+
+  // Takes over the nodes of other, which must use an equal allocator.
+  void steal(List& other) {
+    fake_node_ = other.fake_node_;
+    sz_ = other.sz_;
+    other.fake_node_ = {&other.fake_node_, &other.fake_node_};
+    other.sz_ = 0;
+    adopt_nodes();
+  }
+
+  // Appends n nodes, each built by construct(node, prev, next). Allocators
+  // with allocate_batch hand all of them out as one contiguous block.
+  template <typename Construct>
+  void append_nodes(size_type n, Construct construct) {
+    auto link = [this, &construct](Node* node) {
+      construct(node, fake_node_.prev, &fake_node_);
+      fake_node_.prev->next = node;
+      fake_node_.prev = node;
+      ++sz_;
+    };
+    if constexpr (HasAllocateBatch<NodeAllocator>::value) {
+      if (n > 1) {
+        allocator_.allocate_batch(n, link);
+        return;
+      }
+    }
+    for (size_type i = 0; i < n; ++i) {
+      Node* node = NodeAllocTraits::allocate(allocator_, 1);
+      try {
+        link(node);
+      } catch (...) {
+        NodeAllocTraits::deallocate(allocator_, node, 1);
+        throw;
+      }
+    }
+  }
+
+  template <typename... Args>
+  Node* create_node(BaseNode* pos, Args&&... args) {
+    Node* node = NodeAllocTraits::allocate(allocator_, 1);
+    try {
+      NodeAllocTraits::construct(allocator_, node, pos->prev, pos,
+                                 std::forward<Args>(args)...);
+    } catch (...) {
+      NodeAllocTraits::deallocate(allocator_, node, 1);
+      throw;
+    }
+    pos->prev->next = node;
+    pos->prev = node;
+    ++sz_;
+    return node;
+  }
+
+  // Moves the nodes [first, last) in front of pos without touching values.
+  // Nothing moves when pos already bounds the range.
+  static void relink(BaseNode* pos, BaseNode* first, BaseNode* last) {
+    if (first == last || pos == first || pos == last) {
+      return;
+    }
+    BaseNode* tail = last->prev;
+    first->prev->next = last;
+    last->prev = first->prev;
+    first->prev = pos->prev;
+    tail->next = pos;
+    pos->prev->next = first;
+    pos->prev = tail;
+  }
+
+  // Moves count nodes [first, last) of other in front of pos. Nodes are
+  // relinked when the allocators are equal and copied otherwise.
+  void take(BaseNode* pos, List& other, BaseNode* first, BaseNode* last,
+            size_type count) {
+    if (allocator_ == other.allocator_) {
+      relink(pos, first, last);
+      sz_ += count;
+      other.sz_ -= count;
+      return;
+    }
+    while (first != last) {
+      BaseNode* next = first->next;
+      insert(const_iterator(pos), static_cast<Node*>(first)->value);
+      other.erase(const_iterator(first));
+      first = next;
+    }
+  }
+
+  template <typename Compare>
+  static BaseNode* merge_chains(BaseNode* left, BaseNode* right,
+                                Compare& compare) {
+    BaseNode head;
+    BaseNode* tail = &head;
+    while (left != nullptr && right != nullptr) {
+      if (compare(static_cast<Node*>(right)->value,
+                  static_cast<Node*>(left)->value)) {
+        tail->next = right;
+        right = right->next;
+      } else {
+        tail->next = left;
+        left = left->next;
+      }
+      tail = tail->next;
+    }
+    tail->next = left != nullptr ? left : right;
+    return head.next;
   }
 
   NodeAllocator allocator_;
@@ -135,102 +595,118 @@ class List {
         fake_node_{&fake_node_, &fake_node_},
         sz_(0) {}
 
-  void push_back(const_reference val) {
-    Node* node = NodeAllocTraits::allocate(allocator_, 1);
-    NodeAllocTraits::construct(allocator_, node, val, fake_node_.prev,
-                               &fake_node_);
-    fake_node_.prev->next = node;
-    fake_node_.prev = node;
-    ++sz_;
-  }
-
-  void push_front(const_reference val) {
-    Node* node = NodeAllocTraits::allocate(allocator_, 1);
-    NodeAllocTraits::construct(allocator_, node, val, &fake_node_,
-                               fake_node_.next);
-    fake_node_.next->prev = node;
-    fake_node_.next = node;
-    ++sz_;
-  }
-
-  List(size_type n) : fake_node_({&fake_node_, &fake_node_}) {
-    size_t i = 0;
+  List(size_type n, const Allocator& another_alloc = Allocator())
+      : allocator_(another_alloc), fake_node_{&fake_node_, &fake_node_} {
     try {
-      for (i = 0; i < n; ++i) {
-        Node* node =
-            static_cast<Node*>(NodeAllocTraits::allocate(allocator_, 1));
-        NodeAllocTraits::construct(allocator_, node, fake_node_.prev,
-                                   &fake_node_);
-        fake_node_.prev->next = node;
-        fake_node_.prev = node;
-        ++sz_;
-      }
+      append_nodes(n, [this](Node* node, BaseNode* prev, BaseNode* next) {
+        NodeAllocTraits::construct(allocator_, node, prev, next);
+      });
     } catch (...) {
-      for (size_t j = 0; j < i; ++j) {
-        pop_front();
-      }
+      clear();
       throw;
     }
   }
 
-  List(size_type n, const Allocator& another_alloc)
-      : allocator_(another_alloc), fake_node_({&fake_node_, &fake_node_}) {
-    for (size_t i = 0; i < n; ++i) {
-      Node* node = NodeAllocTraits::allocate(allocator_, 1);
-      NodeAllocTraits::construct(allocator_, node, fake_node_.prev,
-                                 &fake_node_);
-      fake_node_.prev->next = node;
-      fake_node_.prev = node;
-      ++sz_;
-    }
-  }
-
-  List(size_type n, const value_type& value, const Allocator& other_allocator)
-      : allocator_(other_allocator), fake_node_({&fake_node_, &fake_node_}) {
-    for (size_t i = 0; i < n; ++i) {
-      Node* node = NodeAllocTraits::allocate(allocator_, 1);
-      NodeAllocTraits::construct(allocator_, node, value, fake_node_.prev,
-                                 &fake_node_);
-      fake_node_.prev->next = node;
-      fake_node_.prev = node;
-      ++sz_;
-    }
-  }
-  List(size_type n, const value_type& value)
-      : allocator_(get_allocator()), fake_node_({&fake_node_, &fake_node_}) {
-    for (size_t i = 0; i < n; ++i) {
-      push_back(value);
+  List(size_type n, const value_type& value,
+       const Allocator& other_allocator = Allocator())
+      : allocator_(other_allocator), fake_node_{&fake_node_, &fake_node_} {
+    try {
+      append_nodes(n, [&](Node* node, BaseNode* prev, BaseNode* next) {
+        NodeAllocTraits::construct(allocator_, node, prev, next, value);
+      });
+    } catch (...) {
+      clear();
+      throw;
     }
   }
 
   List<T, Allocator>(const List<T, Allocator>& another)
-      : fake_node_({&fake_node_, &fake_node_}) {
-    allocator_ = NodeAllocTraits::select_on_container_copy_construction(
-        another.allocator_);
+      : allocator_(NodeAllocTraits::select_on_container_copy_construction(
+            another.allocator_)),
+        fake_node_{&fake_node_, &fake_node_} {
     auto it = another.begin();
     try {
-      for (; it != another.end(); ++it) {
-        push_back(*it);
-      }
+      append_nodes(another.sz_,
+                   [&](Node* node, BaseNode* prev, BaseNode* next) {
+                     NodeAllocTraits::construct(allocator_, node, prev, next,
+                                                *it);
+                     ++it;
+                   });
     } catch (...) {
-      for (auto ti = another.begin(); ti != it; ++ti) {
-        pop_front();
-      }
+      clear();
       throw;
     }
   }
 
+  List(List&& another) noexcept
+      : allocator_(another.allocator_), fake_node_{&fake_node_, &fake_node_} {
+    steal(another);
+  }
+
   List& operator=(const List<value_type, Allocator>& another) {
-    List<value_type, Allocator> copy_list = another;
-    if (NodeAllocTraits::propagate_on_container_copy_assignment::value &&
-        allocator_ != another.allocator_) {
-      allocator_ = another.allocator_;
+    if (&another == this) {
+      return *this;
+    }
+    List<value_type, Allocator> copy_list(
+        NodeAllocTraits::propagate_on_container_copy_assignment::value
+            ? another.allocator_
+            : allocator_);
+    for (const_reference value : another) {
+      copy_list.create_node(&copy_list.fake_node_, value);
     }
     swap(copy_list);
-    //    std::swap(fake_node_, copy_list.fake_node_);
     return *this;
   }
 
+  // Nodes change hands when the allocator propagates or compares equal;
+  // otherwise every value is moved into a node from our own allocator.
+  List& operator=(List&& another) noexcept(
+      NodeAllocTraits::propagate_on_container_move_assignment::value ||
+      NodeAllocTraits::is_always_equal::value) {
+    if (&another == this) {
+      return *this;
+    }
+    clear();
+    if (NodeAllocTraits::propagate_on_container_move_assignment::value) {
+      allocator_ = another.allocator_;
+      steal(another);
+    } else if (allocator_ == another.allocator_) {
+      steal(another);
+    } else {
+      for (reference value : another) {
+        create_node(&fake_node_, std::move(value));
+      }
+      another.clear();
+    }
+    return *this;
+  }
+
+  void push_back(const_reference val) { create_node(&fake_node_, val); }
+  void push_back(value_type&& val) {
+    create_node(&fake_node_, std::move(val));
+  }
+  void push_front(const_reference val) {
+    create_node(fake_node_.next, val);
+  }
+  void push_front(value_type&& val) {
+    create_node(fake_node_.next, std::move(val));
+  }
+
+  template <typename... Args>
+  reference emplace_back(Args&&... args) {
+    return create_node(&fake_node_, std::forward<Args>(args)...)->value;
+  }
+  template <typename... Args>
+  reference emplace_front(Args&&... args) {
+    return create_node(fake_node_.next, std::forward<Args>(args)...)->value;
+  }
+
+  void clear() {
+    while (sz_ != 0) {
+      pop_back();
+    }
+  }
+
   void pop_front() {
     Node* deleting_elem = static_cast<Node*>(fake_node_.next);
     --sz_;
@@ -341,26 +817,23 @@ class List {
   const_reverse_iterator rbegin() const {
     return const_reverse_iterator(const_cast<BaseNode*>(&fake_node_));
   }
-  const_reverse_iterator crbegin() const {
-    return const_iterator(const_cast<BaseNode*>(&fake_node_));
-  }
+  const_reverse_iterator crbegin() const { return rbegin(); }
 
-  reverse_iterator rend() { return reverse_iterator(fake_node_.prev); }
+  reverse_iterator rend() { return reverse_iterator(begin()); }
   const_reverse_iterator rend() const {
-    return const_reverse_iterator(fake_node_.prev);
-  }
-  const_reverse_iterator crend() const {
-    return const_reverse_iterator(fake_node_.prev);
+    return const_reverse_iterator(begin());
   }
+  const_reverse_iterator crend() const { return rend(); }
 
-  void insert(const_iterator iter, const_reference value) {
-    Node* inserted_node =
-        static_cast<Node*>(NodeAllocTraits::allocate(allocator_, 1));
-    NodeAllocTraits::construct(allocator_, inserted_node, value,
-                               iter.node_ptr_->prev, iter.node_ptr_);
-    iter.node_ptr_->prev->next = inserted_node;
-    iter.node_ptr_->prev = inserted_node;
-    ++sz_;
+  template <typename... Args>
+  iterator emplace(const_iterator iter, Args&&... args) {
+    return iterator(create_node(iter.node_ptr_, std::forward<Args>(args)...));
+  }
+  iterator insert(const_iterator iter, const_reference value) {
+    return emplace(iter, value);
+  }
+  iterator insert(const_iterator iter, value_type&& value) {
+    return emplace(iter, std::move(value));
   }
 
   void erase(const_iterator iter) {
@@ -371,10 +844,114 @@ class List {
     NodeAllocTraits::deallocate(allocator_, deleted_node, 1);
     --sz_;
   }
-  ~List() {
-    while (sz_ != 0) {
-      pop_back();
+  void splice(const_iterator pos, List& other) {
+    take(pos.node_ptr_, other, other.fake_node_.next, &other.fake_node_,
+         other.sz_);
+  }
+  void splice(const_iterator pos, List& other, const_iterator iter) {
+    take(pos.node_ptr_, other, iter.node_ptr_, iter.node_ptr_->next, 1);
+  }
+  void splice(const_iterator pos, List& other, const_iterator first,
+              const_iterator last) {
+    size_type count = &other == this ? 0 : std::distance(first, last);
+    take(pos.node_ptr_, other, first.node_ptr_, last.node_ptr_, count);
+  }
+
+  template <typename Compare = std::less<>>
+  void merge(List& other, Compare compare = Compare()) {
+    if (&other == this) {
+      return;
+    }
+    BaseNode* pos = fake_node_.next;
+    while (pos != &fake_node_ && other.sz_ != 0) {
+      BaseNode* first = other.fake_node_.next;
+      if (compare(static_cast<Node*>(first)->value,
+                  static_cast<Node*>(pos)->value)) {
+        take(pos, other, first, first->next, 1);
+      } else {
+        pos = pos->next;
+      }
+    }
+    splice(end(), other);
+  }
+
+  // Bottom-up merge sort over the nodes: bins[i] holds a sorted run of
+  // 2^i nodes, older runs in higher bins, so equal values keep their order.
+  template <typename Compare = std::less<>>
+  void sort(Compare compare = Compare()) {
+    if (sz_ < 2) {
+      return;
+    }
+    BaseNode* bins[64] = {};
+    fake_node_.prev->next = nullptr;
+    BaseNode* node = fake_node_.next;
+    while (node != nullptr) {
+      BaseNode* run = node;
+      node = node->next;
+      run->next = nullptr;
+      size_t i = 0;
+      for (; bins[i] != nullptr; ++i) {
+        run = merge_chains(bins[i], run, compare);
+        bins[i] = nullptr;
+      }
+      bins[i] = run;
+    }
+    BaseNode* sorted = nullptr;
+    for (BaseNode* bin : bins) {
+      if (bin != nullptr) {
+        sorted = merge_chains(bin, sorted, compare);
+      }
+    }
+    BaseNode* prev = &fake_node_;
+    for (node = sorted; node != nullptr; node = node->next) {
+      node->prev = prev;
+      prev->next = node;
+      prev = node;
     }
+    prev->next = &fake_node_;
+    fake_node_.prev = prev;
   }
+
+  void reverse() {
+    BaseNode* node = &fake_node_;
+    do {
+      std::swap(node->prev, node->next);
+      node = node->prev;
+    } while (node != &fake_node_);
+  }
+
+  template <typename Predicate>
+  size_type remove_if(Predicate predicate) {
+    size_type removed = 0;
+    for (BaseNode* node = fake_node_.next; node != &fake_node_;) {
+      BaseNode* next = node->next;
+      if (predicate(static_cast<Node*>(node)->value)) {
+        erase(const_iterator(node));
+        ++removed;
+      }
+      node = next;
+    }
+    return removed;
+  }
+
+  template <typename BinaryPredicate = std::equal_to<>>
+  size_type unique(BinaryPredicate equal = BinaryPredicate()) {
+    size_type removed = 0;
+    if (sz_ == 0) {
+      return removed;
+    }
+    for (BaseNode* node = fake_node_.next->next; node != &fake_node_;) {
+      BaseNode* next = node->next;
+      if (equal(static_cast<Node*>(node->prev)->value,
+                static_cast<Node*>(node)->value)) {
+        erase(const_iterator(node));
+        ++removed;
+      }
+      node = next;
+    }
+    return removed;
+  }
+
+  ~List() { clear(); }
 };
 
@@ -0,0 +1,89 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "concurrent_storage.h"
+#include "stackallocator.h"
+
+// Allocation throughput of the storage variants under contention. Every run
+// makes kAllocations allocations of kBlock bytes in total, split evenly
+// between the threads, from one storage shared by all of them.
+
+constexpr size_t kAllocations = 4'000'000;
+constexpr size_t kBlock = 32;
+constexpr size_t kStorageSize = 160'000'000;
+
+class LockedStackStorage {
+ public:
+  void* allocate(size_t n, size_t sz_of, size_t alignment) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return storage_.allocate(n, sz_of, alignment);
+  }
+
+ private:
+  std::mutex mutex_;
+  StackStorage<kStorageSize> storage_;
+};
+
+class HeapStorage {
+ public:
+  void* allocate(size_t n, size_t sz_of, size_t) {
+    return ::operator new(n * sz_of);
+  }
+};
+
+template <typename Storage>
+double Run(size_t threads_count) {
+  auto storage = std::make_unique<Storage>();
+  size_t per_thread = kAllocations / threads_count;
+  std::vector<std::vector<void*>> blocks(threads_count);
+  for (std::vector<void*>& thread_blocks : blocks) {
+    thread_blocks.reserve(per_thread);
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < threads_count; ++t) {
+    threads.emplace_back([&storage, &thread_blocks = blocks[t], per_thread] {
+      for (size_t i = 0; i < per_thread; ++i) {
+        void* block = storage->allocate(1, kBlock, alignof(size_t));
+        if (block == nullptr) {
+          std::abort();
+        }
+        *static_cast<size_t*>(block) = i;
+        thread_blocks.push_back(block);
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  auto finish = std::chrono::steady_clock::now();
+
+  if constexpr (std::is_same_v<Storage, HeapStorage>) {
+    for (std::vector<void*>& thread_blocks : blocks) {
+      for (void* block : thread_blocks) {
+        ::operator delete(block);
+      }
+    }
+  }
+  double seconds = std::chrono::duration<double>(finish - start).count();
+  return per_thread * threads_count / seconds / 1e6;
+}
+
+int main() {
+  std::printf("%-8s %14s %14s %14s %14s\n", "threads", "heap", "mutex",
+              "atomic", "thread cache");
+  for (size_t threads = 1; threads <= 64; threads *= 2) {
+    std::printf("%-8zu %14.2f %14.2f %14.2f %14.2f\n", threads,
+                Run<HeapStorage>(threads), Run<LockedStackStorage>(threads),
+                Run<AtomicStackStorage<kStorageSize>>(threads),
+                Run<ThreadCachedStackStorage<kStorageSize>>(threads));
+  }
+  std::printf("(million allocations per second)\n");
+}
@@ -0,0 +1,114 @@
+#ifndef STACK_STORAGE_STATS
+#define STACK_STORAGE_STATS
+#endif
+
+#include <cassert>
+#include <cstdio>
+#include <iterator>
+#include <list>
+#include <memory>
+#include <sstream>
+
+#include "stackallocator.h"
+
+// Allocation profile of a StackStorage under the ListPerformanceTest
+// workload from mytests.cpp, for std::list and List alike.
+
+constexpr size_t kStorageSize = 200'000'000;
+
+// Same sequence of operations as ListPerformanceTest, without the timing.
+template <class List>
+void Workload(List&& l) {
+  std::ostringstream oss;
+  for (int i = 0; i < 1'000'000; ++i) {
+    l.push_back(i);
+  }
+  auto it = l.begin();
+  for (int i = 0; i < 1'000'000; ++i) {
+    l.push_front(i);
+  }
+  oss << *it;
+  auto it2 = std::prev(it);
+  for (int i = 0; i < 2'000'000; ++i) {
+    l.insert(it, i);
+    if (i % 534'555 == 0) {
+      oss << *it;
+    }
+  }
+  oss << *it;
+  for (int i = 0; i < 1'500'000; ++i) {
+    l.pop_back();
+    if (i % 342'985 == 0) oss << *l.rbegin();
+  }
+  oss << *l.rbegin();
+  for (int i = 0; i < 1'000'000; ++i) {
+    l.erase(it2++);
+    if (i % 432'098 == 0) oss << *it2;
+  }
+  oss << *it2;
+  for (int i = 0; i < 1'000'000; ++i) {
+    l.pop_front();
+  }
+  oss << *l.begin();
+  for (int i = 0; i < 1'000'000; ++i) {
+    l.push_back(i);
+  }
+  oss << *l.rbegin();
+  assert(oss.str() ==
+         "000000999998657013314028197104316280581499999043209886419699999910000"
+         "00999999");
+}
+
+struct TraceCounter {
+  size_t events = 0;
+  size_t largest = 0;
+};
+
+void Count(void* context, const void*, size_t bytes, bool allocated) {
+  auto* counter = static_cast<TraceCounter*>(context);
+  ++counter->events;
+  if (allocated && bytes > counter->largest) {
+    counter->largest = bytes;
+  }
+}
+
+void Print(const char* name, const StackStorage<kStorageSize>& storage,
+           const TraceCounter& counter) {
+  const StorageStats& stats = storage.stats();
+  std::printf("%s\n", name);
+  std::printf("  allocations         %zu (%zu from free lists, %zu failed)\n",
+              stats.allocations, stats.free_list_hits,
+              stats.failed_allocations);
+  std::printf("  bytes in use        %zu, high-water mark %zu\n",
+              stats.bytes_in_use, stats.high_water);
+  std::printf("  bytes carved        %zu of %zu (%.1f%%), %zu still free\n",
+              stats.bytes_carved, kStorageSize,
+              100.0 * stats.bytes_carved / kStorageSize, storage.available());
+  std::printf("  alignment waste     %zu bytes\n", stats.alignment_waste);
+  std::printf("  trace events        %zu, largest block %zu bytes\n",
+              counter.events, counter.largest);
+  std::printf("  request sizes      ");
+  for (size_t i = 0; i < StorageStats::histogram_buckets; ++i) {
+    if (stats.histogram[i] != 0) {
+      std::printf(" <=%zu:%zu", size_t{8} << i, stats.histogram[i]);
+    }
+  }
+  std::printf("\n");
+}
+
+template <template <typename, typename> class Container>
+void Profile(const char* name) {
+  auto storage = std::make_unique<StackStorage<kStorageSize>>();
+  TraceCounter counter;
+  storage->set_trace_hook(Count, &counter);
+  {
+    StackAllocator<int, kStorageSize> alloc(*storage);
+    Workload(Container<int, StackAllocator<int, kStorageSize>>(alloc));
+  }
+  Print(name, *storage, counter);
+}
+
+int main() {
+  Profile<std::list>("std::list with StackAllocator");
+  Profile<List>("List with StackAllocator");
+}
@@ -0,0 +1,409 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+// List that keeps up to node_capacity_ values in every node, so iteration
+// walks arrays instead of chasing one pointer per value. Insertion into a
+// full node splits it in half and erasure merges a sparse node with its
+// successor. Unlike List, insert and erase shift values within a node and
+// therefore invalidate iterators to that node.
+template <typename T, typename Allocator = std::allocator<T>>
+class UnrolledList {
+ private:
+  using value_type = T;
+  using reference = T&;
+  using const_reference = const T&;
+  using size_type = std::size_t;
+  using difference_type = ptrdiff_t;
+
+  static constexpr size_t node_capacity_ =
+      std::max<size_t>(256 / sizeof(T), 4);
+
+  // The sentinel is a BaseNode with count 0, which makes iterators reaching
+  // it equal to end().
+  struct BaseNode {
+    BaseNode* prev;
+    BaseNode* next;
+    size_t count = 0;
+    BaseNode() = default;
+    BaseNode(BaseNode* prev, BaseNode* next) : prev(prev), next(next){};
+  };
+  struct Node : public BaseNode {
+    alignas(T) char cells[node_capacity_ * sizeof(T)];
+    Node(BaseNode* prev, BaseNode* next) : BaseNode(prev, next){};
+    T* cell(size_t index) { return reinterpret_cast<T*>(cells) + index; }
+  };
+
+  using NodeAllocator =
+      typename std::allocator_traits<Allocator>::template rebind_alloc<Node>;
+  using NodeAllocTraits =
+      typename std::allocator_traits<Allocator>::template rebind_traits<Node>;
+
+  NodeAllocator allocator_;
+  BaseNode fake_node_;
+  size_type sz_ = 0;
+
+  Node* create_node(BaseNode* prev, BaseNode* next) {
+    Node* node = NodeAllocTraits::allocate(allocator_, 1);
+    NodeAllocTraits::construct(allocator_, node, prev, next);
+    prev->next = node;
+    next->prev = node;
+    return node;
+  }
+
+  void free_node(Node* node) {
+    node->prev->next = node->next;
+    node->next->prev = node->prev;
+    NodeAllocTraits::destroy(allocator_, node);
+    NodeAllocTraits::deallocate(allocator_, node, 1);
+  }
+
+  // Moves the values from index on into a new node right after node.
+  void split(Node* node, size_t index) {
+    Node* tail = create_node(node, node->next);
+    std::uninitialized_move(node->cell(index), node->cell(node->count),
+                            tail->cell(0));
+    std::destroy(node->cell(index), node->cell(node->count));
+    tail->count = node->count - index;
+    node->count = index;
+  }
+
+  // Appends n values, filling every new node before starting the next one;
+  // construct(cell) builds one value in place.
+  template <typename Construct>
+  void append_values(size_type n, Construct construct) {
+    while (n > 0) {
+      Node* node = create_node(fake_node_.prev, &fake_node_);
+      for (; n > 0 && node->count < node_capacity_; --n) {
+        try {
+          construct(node->cell(node->count));
+        } catch (...) {
+          if (node->count == 0) {
+            free_node(node);
+          }
+          throw;
+        }
+        ++node->count;
+        ++sz_;
+      }
+    }
+  }
+
+  // Takes over the nodes of other, leaving it empty.
+  void steal(UnrolledList& other) {
+    sz_ = other.sz_;
+    if (sz_ != 0) {
+      fake_node_ = other.fake_node_;
+      fake_node_.next->prev = &fake_node_;
+      fake_node_.prev->next = &fake_node_;
+    }
+    other.fake_node_ = {&other.fake_node_, &other.fake_node_};
+    other.sz_ = 0;
+  }
+
+  void swap(UnrolledList& other) {
+    std::swap(allocator_, other.allocator_);
+    std::swap(fake_node_, other.fake_node_);
+    std::swap(sz_, other.sz_);
+    for (UnrolledList* list : {this, &other}) {
+      BaseNode& fake = list->fake_node_;
+      if (list->sz_ == 0) {
+        fake = {&fake, &fake};
+      } else {
+        fake.next->prev = &fake;
+        fake.prev->next = &fake;
+      }
+    }
+  }
+
+ public:
+  template <bool IsConst>
+  class common_iterator {
+   public:
+    using Type = std::conditional_t<IsConst, const T, T>;
+    using reference = Type&;
+    using pointer = Type*;
+    using iterator_category = std::bidirectional_iterator_tag;
+    using value_type = T;
+    using difference_type = ptrdiff_t;
+
+    common_iterator() = default;
+
+    common_iterator(const common_iterator<false>& another)
+        : node_ptr_(another.node_ptr_),
+          cell_(another.cell_),
+          last_(another.last_) {}
+    common_iterator& operator=(const common_iterator<false>& another) {
+      node_ptr_ = another.node_ptr_;
+      cell_ = another.cell_;
+      last_ = another.last_;
+      return *this;
+    }
+
+    reference operator*() const { return *cell_; }
+    pointer operator->() const { return cell_; }
+
+    common_iterator& operator++() {
+      if (++cell_ == last_) {
+        *this = common_iterator(node_ptr_->next, 0);
+      }
+      return *this;
+    }
+    common_iterator operator++(int) {
+      common_iterator copy_iter = *this;
+      ++*this;
+      return copy_iter;
+    }
+    common_iterator& operator--() {
+      if (last_ == nullptr || cell_ == static_cast<Node*>(node_ptr_)->cell(0)) {
+        Node* prev = static_cast<Node*>(node_ptr_->prev);
+        *this = common_iterator(prev, prev->count - 1);
+      } else {
+        --cell_;
+      }
+      return *this;
+    }
+    common_iterator operator--(int) {
+      common_iterator copy_iter = *this;
+      --*this;
+      return copy_iter;
+    }
+
+    bool operator==(const common_iterator& another) const {
+      return cell_ == another.cell_;
+    }
+    bool operator!=(const common_iterator& another) const {
+      return cell_ != another.cell_;
+    }
+
+   private:
+    friend class UnrolledList;
+    template <bool>
+    friend class common_iterator;
+
+    common_iterator(BaseNode* ptr, size_t index) : node_ptr_(ptr) {
+      if (index < ptr->count) {
+        cell_ = static_cast<Node*>(ptr)->cell(index);
+        last_ = cell_ + (ptr->count - index);
+      }
+    }
+    size_t index() const {
+      if (last_ == nullptr) {
+        return 0;
+      }
+      return cell_ - static_cast<Node*>(node_ptr_)->cell(0);
+    }
+
+    BaseNode* node_ptr_ = nullptr;
+    T* cell_ = nullptr;
+    T* last_ = nullptr;
+  };
+
+  using iterator = common_iterator<false>;
+  using const_iterator = common_iterator<true>;
+  using reverse_iterator = std::reverse_iterator<iterator>;
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+  UnrolledList() : fake_node_{&fake_node_, &fake_node_} {}
+  explicit UnrolledList(const Allocator& alloc)
+      : allocator_(alloc), fake_node_{&fake_node_, &fake_node_} {}
+  UnrolledList(size_type n, const Allocator& alloc = Allocator())
+      : UnrolledList(alloc) {
+    try {
+      append_values(n, [this](T* cell) {
+        NodeAllocTraits::construct(allocator_, cell);
+      });
+    } catch (...) {
+      clear();
+      throw;
+    }
+  }
+  UnrolledList(size_type n, const_reference value,
+               const Allocator& alloc = Allocator())
+      : UnrolledList(alloc) {
+    try {
+      append_values(n, [this, &value](T* cell) {
+        NodeAllocTraits::construct(allocator_, cell, value);
+      });
+    } catch (...) {
+      clear();
+      throw;
+    }
+  }
+  UnrolledList(const UnrolledList& another)
+      : allocator_(NodeAllocTraits::select_on_container_copy_construction(
+            another.allocator_)),
+        fake_node_{&fake_node_, &fake_node_} {
+    try {
+      for (const_reference value : another) {
+        push_back(value);
+      }
+    } catch (...) {
+      clear();
+      throw;
+    }
+  }
+  UnrolledList& operator=(const UnrolledList& another) {
+    UnrolledList copy(
+        NodeAllocTraits::propagate_on_container_copy_assignment::value
+            ? another.allocator_
+            : allocator_);
+    for (const_reference value : another) {
+      copy.push_back(value);
+    }
+    swap(copy);
+    return *this;
+  }
+  UnrolledList(UnrolledList&& another) noexcept
+      : allocator_(another.allocator_), fake_node_{&fake_node_, &fake_node_} {
+    steal(another);
+  }
+
+  // Nodes change hands when the allocator propagates or compares equal;
+  // otherwise every value is moved into a node from our own allocator.
+  UnrolledList& operator=(UnrolledList&& another) noexcept(
+      NodeAllocTraits::propagate_on_container_move_assignment::value ||
+      NodeAllocTraits::is_always_equal::value) {
+    if (&another == this) {
+      return *this;
+    }
+    clear();
+    if (NodeAllocTraits::propagate_on_container_move_assignment::value) {
+      allocator_ = another.allocator_;
+      steal(another);
+    } else if (allocator_ == another.allocator_) {
+      steal(another);
+    } else {
+      auto it = another.begin();
+      append_values(another.sz_, [this, &it](T* cell) {
+        NodeAllocTraits::construct(allocator_, cell, std::move(*it));
+        ++it;
+      });
+      another.clear();
+    }
+    return *this;
+  }
+  ~UnrolledList() { clear(); }
+
+  NodeAllocator get_allocator() const { return allocator_; }
+  size_type size() const { return sz_; }
+
+  iterator begin() { return iterator(fake_node_.next, 0); }
+  const_iterator begin() const {
+    return const_iterator(fake_node_.next, 0);
+  }
+  const_iterator cbegin() const { return begin(); }
+  iterator end() { return iterator(&fake_node_, 0); }
+  const_iterator end() const {
+    return const_iterator(const_cast<BaseNode*>(&fake_node_), 0);
+  }
+  const_iterator cend() const { return end(); }
+
+  reverse_iterator rbegin() { return reverse_iterator(end()); }
+  const_reverse_iterator rbegin() const {
+    return const_reverse_iterator(end());
+  }
+  reverse_iterator rend() { return reverse_iterator(begin()); }
+  const_reverse_iterator rend() const {
+    return const_reverse_iterator(begin());
+  }
+
+  iterator insert(const_iterator iter, const_reference value);
+  iterator erase(const_iterator iter);
+
+  void push_back(const_reference value) { insert(end(), value); }
+  void push_front(const_reference value) { insert(begin(), value); }
+  void pop_back() { erase(--end()); }
+  void pop_front() { erase(begin()); }
+
+  void clear() {
+    while (fake_node_.next != &fake_node_) {
+      Node* node = static_cast<Node*>(fake_node_.next);
+      std::destroy(node->cell(0), node->cell(node->count));
+      free_node(node);
+    }
+    sz_ = 0;
+  }
+};
+
+template <typename T, typename Allocator>
+typename UnrolledList<T, Allocator>::iterator
+UnrolledList<T, Allocator>::insert(const_iterator iter,
+                                   const_reference value) {
+  BaseNode* base = iter.node_ptr_;
+  size_t index = iter.index();
+  if (index == 0 && base->prev != &fake_node_ &&
+      (base == &fake_node_ ||
+       static_cast<Node*>(base->prev)->count < node_capacity_)) {
+    base = base->prev;
+    index = static_cast<Node*>(base)->count;
+  }
+  Node* node = nullptr;
+  if (base == &fake_node_) {
+    node = create_node(fake_node_.prev, &fake_node_);
+  } else {
+    node = static_cast<Node*>(base);
+    if (node->count == node_capacity_) {
+      if (index == node_capacity_) {
+        node = create_node(node, node->next);
+        index = 0;
+      } else if (index == 0) {
+        node = create_node(node->prev, node);
+      } else {
+        split(node, node_capacity_ / 2);
+        if (index > node_capacity_ / 2) {
+          index -= node_capacity_ / 2;
+          node = static_cast<Node*>(node->next);
+        }
+      }
+    }
+  }
+  try {
+    NodeAllocTraits::construct(allocator_, node->cell(node->count), value);
+  } catch (...) {
+    if (node->count == 0) {
+      free_node(node);
+    }
+    throw;
+  }
+  ++node->count;
+  std::rotate(node->cell(index), node->cell(node->count - 1),
+              node->cell(node->count));
+  ++sz_;
+  return iterator(node, index);
+}
+
+template <typename T, typename Allocator>
+typename UnrolledList<T, Allocator>::iterator
+UnrolledList<T, Allocator>::erase(const_iterator iter) {
+  Node* node = static_cast<Node*>(iter.node_ptr_);
+  size_t index = iter.index();
+  std::move(node->cell(index + 1), node->cell(node->count), node->cell(index));
+  --node->count;
+  NodeAllocTraits::destroy(allocator_, node->cell(node->count));
+  --sz_;
+  if (node->count == 0) {
+    BaseNode* next = node->next;
+    free_node(node);
+    return iterator(next, 0);
+  }
+  BaseNode* next = node->next;
+  if (next != &fake_node_ && node->count < node_capacity_ / 2 &&
+      node->count + static_cast<Node*>(next)->count <= node_capacity_) {
+    Node* absorbed = static_cast<Node*>(next);
+    std::uninitialized_move(absorbed->cell(0), absorbed->cell(absorbed->count),
+                            node->cell(node->count));
+    std::destroy(absorbed->cell(0), absorbed->cell(absorbed->count));
+    node->count += absorbed->count;
+    free_node(absorbed);
+  }
+  if (index == node->count) {
+    return iterator(node->next, 0);
+  }
+  return iterator(node, index);
+}
@@ -0,0 +1,164 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include "smart_pointers.h"
+
+// SharedPtr<T> slot that many threads may load and replace at once without
+// locks, using split reference counting. The slot is a single 64-bit word
+// holding a pointer to a Record with the published SharedPtr in its low 48
+// bits and an external count in its high 16 bits. A reader bumps the
+// external count to pin the record, copies the SharedPtr out of it and
+// then unpins it again: by decrementing the external count if the record is
+// still published, or its internal count otherwise. Whoever replaces a
+// record moves its external count into the internal one, and the record is
+// freed when the sum drops to zero. At most 65535 loads may be in flight on
+// one slot at a time.
+template <typename T>
+class AtomicSharedPtr {
+ public:
+  AtomicSharedPtr() = default;
+  explicit AtomicSharedPtr(SharedPtr<T> desired)
+      : word_(Pack(MakeRecord(std::move(desired)), 0)) {}
+  AtomicSharedPtr(const AtomicSharedPtr&) = delete;
+  AtomicSharedPtr& operator=(const AtomicSharedPtr&) = delete;
+  ~AtomicSharedPtr() { delete RecordOf(word_.load(std::memory_order_relaxed)); }
+
+  bool is_lock_free() const { return word_.is_lock_free(); }
+
+  SharedPtr<T> load() const {
+    uint64_t word = Pin();
+    Record* record = RecordOf(word);
+    if (record == nullptr) {
+      return SharedPtr<T>();
+    }
+    SharedPtr<T> result = record->value;
+    Unpin(record);
+    return result;
+  }
+
+  void store(SharedPtr<T> desired) { exchange(std::move(desired)); }
+
+  SharedPtr<T> exchange(SharedPtr<T> desired) {
+    uint64_t old = word_.exchange(Pack(MakeRecord(std::move(desired)), 0),
+                                  std::memory_order_acq_rel);
+    Record* record = RecordOf(old);
+    if (record == nullptr) {
+      return SharedPtr<T>();
+    }
+    // Readers pinning the record may still copy its value, so it is copied
+    // rather than moved out.
+    SharedPtr<T> result = record->value;
+    Retire(record, ExternalOf(old));
+    return result;
+  }
+
+  // Replaces the value with desired if it still owns the same object as
+  // expected; otherwise loads the current value into expected.
+  bool compare_exchange_strong(SharedPtr<T>& expected, SharedPtr<T> desired) {
+    Record* replacement = nullptr;
+    while (true) {
+      uint64_t word = Pin();
+      Record* record = RecordOf(word);
+      SharedPtr<T> current;
+      if (record != nullptr) {
+        current = record->value;
+      }
+      if (current.cb_ptr_ != expected.cb_ptr_ ||
+          current.ptr_ != expected.ptr_) {
+        if (record != nullptr) {
+          Unpin(record);
+        }
+        delete replacement;
+        expected = current;
+        return false;
+      }
+      if (replacement == nullptr) {
+        replacement = MakeRecord(std::move(desired));
+      }
+      if (word_.compare_exchange_strong(word, Pack(replacement, 0),
+                                        std::memory_order_acq_rel)) {
+        if (record != nullptr) {
+          // The external count includes this thread's own pin.
+          Retire(record, ExternalOf(word) - 1);
+        }
+        return true;
+      }
+      if (record != nullptr) {
+        Unpin(record);
+      }
+    }
+  }
+  bool compare_exchange_weak(SharedPtr<T>& expected, SharedPtr<T> desired) {
+    return compare_exchange_strong(expected, std::move(desired));
+  }
+
+ private:
+  static_assert(sizeof(void*) == 8, "pointers are packed into 48 bits");
+
+  struct Record {
+    SharedPtr<T> value;
+    std::atomic<int64_t> internal_count{0};
+  };
+
+  static constexpr int kPointerBits = 48;
+  static constexpr uint64_t kPointerMask = (uint64_t{1} << kPointerBits) - 1;
+  static constexpr uint64_t kOneExternal = uint64_t{1} << kPointerBits;
+
+  static Record* MakeRecord(SharedPtr<T> value) {
+    if (value.cb_ptr_ == nullptr) {
+      return nullptr;
+    }
+    Record* record = new Record;
+    record->value = std::move(value);
+    return record;
+  }
+  static uint64_t Pack(Record* record, uint64_t external) {
+    return reinterpret_cast<uintptr_t>(record) | external << kPointerBits;
+  }
+  static Record* RecordOf(uint64_t word) {
+    return reinterpret_cast<Record*>(word & kPointerMask);
+  }
+  static uint64_t ExternalOf(uint64_t word) { return word >> kPointerBits; }
+
+  // Bumps the external count and returns the word including the bump. A
+  // null slot is returned without being pinned.
+  uint64_t Pin() const {
+    uint64_t word = word_.load(std::memory_order_relaxed);
+    while (RecordOf(word) != nullptr &&
+           !word_.compare_exchange_weak(word, word + kOneExternal,
+                                        std::memory_order_acquire,
+                                        std::memory_order_relaxed)) {
+    }
+    return RecordOf(word) == nullptr ? word : word + kOneExternal;
+  }
+
+  void Unpin(Record* record) const {
+    uint64_t word = word_.load(std::memory_order_relaxed);
+    while (RecordOf(word) == record) {
+      if (word_.compare_exchange_weak(word, word - kOneExternal,
+                                      std::memory_order_release,
+                                      std::memory_order_relaxed)) {
+        return;
+      }
+    }
+    // The record was replaced and its pin moved into the internal count.
+    if (record->internal_count.fetch_sub(1, std::memory_order_acq_rel) ==
+        1) {
+      delete record;
+    }
+  }
+
+  // Called once by whoever took record out of the slot while external
+  // readers still had it pinned.
+  static void Retire(Record* record, uint64_t external) {
+    int64_t pins = static_cast<int64_t>(external);
+    if (record->internal_count.fetch_add(pins, std::memory_order_acq_rel) ==
+        -pins) {
+      delete record;
+    }
+  }
+
+  mutable std::atomic<uint64_t> word_{0};
+};
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstddef>
+#include <utility>
+
+#include "smart_pointers.h"
+
+template <typename T>
+class IntrusivePtr;
+
+// Mixin that keeps the reference count inside the object, so IntrusivePtr
+// needs neither a control block nor a second pointer. Derived is the class
+// deleted when the count drops to zero; Policy is AtomicRefCount or
+// PlainRefCount as for SharedPtr. Copies of an object start with their own
+// zero count.
+template <typename Derived, typename Policy = AtomicRefCount>
+class RefCounted {
+ public:
+  size_t use_count() const { return Policy::Load(ref_count_); }
+
+  // The object must already be owned by an IntrusivePtr: a count that
+  // drops back to zero deletes it, so this must not be called from the
+  // constructor.
+  IntrusivePtr<Derived> intrusive_from_this() {
+    return IntrusivePtr<Derived>(static_cast<Derived*>(this));
+  }
+
+ protected:
+  RefCounted() = default;
+  RefCounted(const RefCounted&) {}
+  RefCounted& operator=(const RefCounted&) { return *this; }
+  ~RefCounted() = default;
+
+ private:
+  friend void intrusiveAddRef(const RefCounted* object) {
+    Policy::Increment(object->ref_count_);
+  }
+  friend void intrusiveRelease(const RefCounted* object) {
+    if (Policy::Decrement(object->ref_count_) == 1) {
+      delete static_cast<const Derived*>(object);
+    }
+  }
+
+  mutable typename Policy::Count ref_count_ = 0;
+};
+
+// Single-pointer handle to an object that counts its own references through
+// the ADL functions intrusiveAddRef and intrusiveRelease, normally those of
+// RefCounted.
+template <typename T>
+class IntrusivePtr {
+ public:
+  IntrusivePtr() = default;
+  IntrusivePtr(T* pointer) : ptr_(pointer) {
+    if (ptr_ != nullptr) {
+      intrusiveAddRef(ptr_);
+    }
+  }
+  IntrusivePtr(const IntrusivePtr& other) : IntrusivePtr(other.ptr_) {}
+  template <typename U>
+  IntrusivePtr(const IntrusivePtr<U>& other) : IntrusivePtr(other.get()) {}
+  IntrusivePtr(IntrusivePtr&& other) noexcept : ptr_(other.ptr_) {
+    other.ptr_ = nullptr;
+  }
+  template <typename U>
+  IntrusivePtr(IntrusivePtr<U>&& other) noexcept : ptr_(other.ptr_) {
+    other.ptr_ = nullptr;
+  }
+  ~IntrusivePtr() {
+    if (ptr_ != nullptr) {
+      intrusiveRelease(ptr_);
+    }
+  }
+
+  IntrusivePtr& operator=(IntrusivePtr other) {
+    swap(other);
+    return *this;
+  }
+
+  void swap(IntrusivePtr& other) { std::swap(ptr_, other.ptr_); }
+  void reset() { IntrusivePtr().swap(*this); }
+  void reset(T* pointer) { IntrusivePtr(pointer).swap(*this); }
+
+  T& operator*() const { return *ptr_; }
+  T* operator->() const { return ptr_; }
+  T* get() const { return ptr_; }
+  explicit operator bool() const { return ptr_ != nullptr; }
+  size_t use_count() const { return ptr_ == nullptr ? 0 : ptr_->use_count(); }
+
+ private:
+  template <typename U>
+  friend class IntrusivePtr;
+
+  T* ptr_ = nullptr;
+};
+
+template <typename T, typename... Args>
+IntrusivePtr<T> makeIntrusive(Args&&... args) {
+  return IntrusivePtr<T>(new T(std::forward<Args>(args)...));
+}
+
+// SharedPtr for APIs that take one, holding a reference of the object for
+// as long as any of its copies lives.
+template <typename T>
+SharedPtr<T> toSharedPtr(const IntrusivePtr<T>& ptr) {
+  if (!ptr) {
+    return SharedPtr<T>();
+  }
+  intrusiveAddRef(ptr.get());
+  return SharedPtr<T>(ptr.get(), [](T* object) { intrusiveRelease(object); });
+}
@@ -3,8 +3,12 @@
 #include <vector>
 #include <algorithm>
 #include <cassert>
+#include <atomic>
+#include <thread>
 
 #include "smart_pointers.h"
+#include "atomic_shared_ptr.h"
+#include "intrusive_ptr.h"
 
 
 /*template<typename T>
@@ -269,18 +273,21 @@ int deallocated = 0;
 int allocate_called = 0;
 int deallocate_called = 0;
 
-int new_called = 0;
-int delete_called = 0;
+std::atomic<int> new_called = 0;
+std::atomic<int> delete_called = 0;
 
 int construct_called = 0;
 int destroy_called = 0;
 
-void* operator new(size_t n) {
+// The replacements are kept out of line: once malloc or free is inlined into
+// a caller that pairs it with operator delete or new, GCC reports the pair
+// as mismatched.
+[[gnu::noinline]] void* operator new(size_t n) {
   ++new_called;
   return std::malloc(n);
 }
 
-void operator delete(void* ptr) noexcept {
+[[gnu::noinline]] void operator delete(void* ptr) noexcept {
   ++delete_called;
   std::free(ptr);
 }
@@ -296,7 +303,7 @@ void operator delete(void* ptr, VerySpecialType) {
 }
 
 // to prevent compiler warnings
-void operator delete(void* ptr, size_t) noexcept {
+[[gnu::noinline]] void operator delete(void* ptr, size_t) noexcept {
   ++delete_called;
   std::free(ptr);
 }
@@ -628,6 +635,295 @@ void test_custom_deleter() {
   assert(custom_deleter_called == 1);
 }
 
+struct Tracked {
+  static std::atomic<int> destructed;
+  int value = 1;
+  ~Tracked() {
+    value = 0;
+    ++destructed;
+  }
+};
+
+std::atomic<int> Tracked::destructed = 0;
+
+void test_concurrent_counts() {
+  Tracked::destructed = 0;
+  {
+    auto sp = makeShared<Tracked>();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+      threads.emplace_back([&sp] {
+        for (int i = 0; i < 100'000; ++i) {
+          SharedPtr<Tracked> copy = sp;
+          WeakPtr<Tracked> weak = copy;
+          auto locked = weak.lock();
+          assert(locked.get() == sp.get() && locked->value == 1);
+        }
+      });
+    }
+    for (std::thread& thread : threads) {
+      thread.join();
+    }
+    assert(sp.use_count() == 1);
+  }
+  assert(Tracked::destructed == 1);
+
+  // The last owner goes away while another thread locks a WeakPtr: lock()
+  // either wins and keeps the object alive or returns null.
+  for (int i = 0; i < 2'000; ++i) {
+    auto sp = makeShared<Tracked>();
+    WeakPtr<Tracked> weak = sp;
+    std::thread releaser([&sp] { sp.reset(); });
+    auto locked = weak.lock();
+    if (locked.get() != nullptr) {
+      assert(locked->value == 1);
+    }
+    releaser.join();
+    locked.reset();
+    assert(weak.expired());
+  }
+  assert(Tracked::destructed == 2'001);
+}
+
+struct LocalEnabled : public EnableSharedFromThis<LocalEnabled, PlainRefCount> {
+  int value = 7;
+};
+
+void test_local_shared_ptr() {
+  static_assert(sizeof(LocalSharedPtr<int>) == sizeof(SharedPtr<int>));
+  Tracked::destructed = 0;
+  {
+    LocalSharedPtr<Tracked> sp = makeLocalShared<Tracked>();
+    LocalWeakPtr<Tracked> weak = sp;
+    {
+      auto copy = sp;
+      auto locked = weak.lock();
+      assert(sp.use_count() == 3 && locked->value == 1);
+    }
+    assert(sp.use_count() == 1);
+    sp.reset();
+    assert(weak.expired() && weak.lock().get() == nullptr);
+  }
+  assert(Tracked::destructed == 1);
+
+  {
+    LocalSharedPtr<Base> base = LocalSharedPtr<Derived>(new Derived());
+    assert(base.use_count() == 1);
+    MyAllocator<Tracked> alloc;
+    auto allocated = allocateLocalShared<Tracked>(alloc);
+    assert(allocated->value == 1);
+  }
+  assert(Tracked::destructed == 2);
+
+  auto enabled = makeLocalShared<LocalEnabled>();
+  auto self = enabled->shared_from_this();
+  assert(self.get() == enabled.get() && enabled.use_count() == 2);
+}
+
+struct Abstract {
+  virtual int Get() const = 0;
+  virtual ~Abstract() = default;
+};
+
+struct Concrete : public Abstract {
+  Tracked tracked;
+  int Get() const override { return tracked.value; }
+};
+
+// SharedPtr only reaches T through its control block, so it works for a
+// type that is incomplete where the pointer is destroyed, and for one whose
+// destructor only a custom deleter can call.
+struct PimplImpl;
+struct PimplHolder {
+  SharedPtr<PimplImpl> impl;
+};
+
+class PrivatelyDestroyed {
+ public:
+  static SharedPtr<PrivatelyDestroyed> Make() {
+    return SharedPtr<PrivatelyDestroyed>(
+        new PrivatelyDestroyed(),
+        [](PrivatelyDestroyed* object) { delete object; });
+  }
+
+ private:
+  ~PrivatelyDestroyed() = default;
+};
+
+void test_control_block_dispatch() {
+  static_assert(sizeof(BaseControlBlock<>) ==
+                sizeof(void*) + 2 * sizeof(uint32_t));
+  Tracked::destructed = 0;
+  {
+    int value = 5;
+    auto from_lvalue = makeShared<int>(value);
+    assert(*from_lvalue == 5);
+    SharedPtr<Abstract> abstract = makeShared<Concrete>();
+    WeakPtr<Abstract> weak = abstract;
+    assert(abstract->Get() == 1);
+    abstract.reset();
+    assert(weak.expired() && Tracked::destructed == 1);
+    SharedPtr<Tracked> separate(new Tracked());
+    SharedPtr<Tracked> inlined = makeShared<Tracked>();
+    PimplHolder holder;
+    auto privately_destroyed = PrivatelyDestroyed::Make();
+  }
+  assert(Tracked::destructed == 3);
+
+  // Without weak references the last owner frees the value and the block in
+  // one go; a weak reference keeps the block until it is released.
+  MyAllocator<Tracked> alloc;
+  int deallocations = deallocate_called;
+  int deleted = custom_deleter_called;
+  Tracked tracked;
+  SharedPtr<Tracked> inlined = allocateShared<Tracked>(alloc);
+  SharedPtr<Tracked> separate(&tracked, MyDeleter(), alloc);
+  inlined.reset();
+  separate.reset();
+  assert(Tracked::destructed == 4);
+  assert(custom_deleter_called == deleted + 1);
+  assert(deallocate_called == deallocations + 2);
+  {
+    inlined = allocateShared<Tracked>(alloc);
+    WeakPtr<Tracked> weak = inlined;
+    inlined.reset();
+    assert(Tracked::destructed == 5);
+    assert(deallocate_called == deallocations + 2);
+  }
+  assert(deallocate_called == deallocations + 3);
+}
+
+void test_atomic_shared_ptr() {
+  Tracked::destructed = 0;
+  {
+    AtomicSharedPtr<Tracked> slot;
+    assert(slot.is_lock_free() && slot.load().get() == nullptr);
+    auto first = makeShared<Tracked>();
+    slot.store(first);
+    assert(slot.load().get() == first.get());
+    assert(first.use_count() == 2);
+    SharedPtr<Tracked> expected;
+    assert(!slot.compare_exchange_strong(expected, makeShared<Tracked>()));
+    assert(expected.get() == first.get() && Tracked::destructed == 1);
+    assert(slot.compare_exchange_strong(expected, SharedPtr<Tracked>()));
+    assert(slot.load().get() == nullptr && first.use_count() == 2);
+    expected.reset();
+    assert(slot.exchange(first).get() == nullptr);
+  }
+  assert(Tracked::destructed == 2);
+
+  // Readers keep loading while a writer publishes new snapshots; every
+  // snapshot must still be alive while someone holds it.
+  {
+    AtomicSharedPtr<int> config(makeShared<int>(0));
+    std::atomic<bool> done = false;
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 3; ++t) {
+      readers.emplace_back([&config, &done] {
+        int last = 0;
+        while (!done) {
+          SharedPtr<int> snapshot = config.load();
+          assert(*snapshot >= last);
+          last = *snapshot;
+        }
+      });
+    }
+    for (int i = 1; i <= 20'000; ++i) {
+      config.store(makeShared<int>(i));
+    }
+    done = true;
+    for (std::thread& reader : readers) {
+      reader.join();
+    }
+    assert(*config.load() == 20'000);
+  }
+
+  // Concurrent increments through compare_exchange lose no update.
+  {
+    AtomicSharedPtr<int> counter(makeShared<int>(0));
+    std::vector<std::thread> writers;
+    for (int t = 0; t < 4; ++t) {
+      writers.emplace_back([&counter] {
+        for (int i = 0; i < 2'000; ++i) {
+          SharedPtr<int> current = counter.load();
+          while (!counter.compare_exchange_weak(
+              current, makeShared<int>(*current + 1))) {
+          }
+        }
+      });
+    }
+    for (std::thread& writer : writers) {
+      writer.join();
+    }
+    assert(*counter.load() == 8'000);
+  }
+}
+
+struct Message : public RefCounted<Message> {
+  Tracked tracked;
+  IntrusivePtr<Message> reply_to;
+  IntrusivePtr<Message> self() { return intrusive_from_this(); }
+};
+
+struct LocalMessage : public RefCounted<LocalMessage, PlainRefCount> {
+  Tracked tracked;
+};
+
+void test_intrusive_ptr() {
+  static_assert(sizeof(IntrusivePtr<Message>) == sizeof(void*));
+  Tracked::destructed = 0;
+  new_called = 0;
+  {
+    auto message = makeIntrusive<Message>();
+    assert(new_called == 1 && message.use_count() == 1);
+    IntrusivePtr<Message> copy = message;
+    IntrusivePtr<Message> self = message->self();
+    assert(self.get() == message.get() && message.use_count() == 3);
+    copy.reset();
+    self = std::move(copy);
+    assert(!self && message.use_count() == 1);
+
+    message->reply_to = makeIntrusive<Message>();
+    Message duplicate = *message;
+    assert(duplicate.use_count() == 0 && message.use_count() == 1);
+    assert(message->reply_to.use_count() == 2);
+
+    SharedPtr<Message> shared = toSharedPtr(message);
+    IntrusivePtr<Message> raw(message.get());
+    message.reset();
+    assert(shared->tracked.value == 1 && raw.use_count() == 2);
+    raw.reset();
+    assert(Tracked::destructed == 0);
+  }
+  // duplicate, the message and its reply.
+  assert(Tracked::destructed == 3);
+
+  {
+    IntrusivePtr<LocalMessage> local(new LocalMessage());
+    auto copy = local;
+    assert(copy.use_count() == 2);
+  }
+  assert(Tracked::destructed == 4);
+
+  {
+    auto shared = makeIntrusive<Message>();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+      threads.emplace_back([&shared] {
+        for (int i = 0; i < 50'000; ++i) {
+          IntrusivePtr<Message> copy = shared;
+          assert(copy->tracked.value == 1);
+        }
+      });
+    }
+    for (std::thread& thread : threads) {
+      thread.join();
+    }
+    assert(shared.use_count() == 1);
+  }
+  assert(Tracked::destructed == 5);
+}
+
 int main() {
   static_assert(!std::is_base_of_v<std::shared_ptr<VerySpecialType>, SharedPtr<VerySpecialType>>,
           "don't try to use std smart pointers");
@@ -656,6 +952,21 @@ int main() {
   test_custom_deleter();
   std::cerr << "Test 5 (custom deleter) passed." << std::endl;
 
+  test_concurrent_counts();
+  std::cerr << "Test 6 (concurrent counts) passed." << std::endl;
+
+  test_local_shared_ptr();
+  std::cerr << "Test 7 (local shared ptr) passed." << std::endl;
+
+  test_control_block_dispatch();
+  std::cerr << "Test 8 (control block dispatch) passed." << std::endl;
+
+  test_atomic_shared_ptr();
+  std::cerr << "Test 9 (atomic shared ptr) passed." << std::endl;
+
+  test_intrusive_ptr();
+  std::cerr << "Test 10 (intrusive ptr) passed." << std::endl;
+
 //  assert((!std::is_base_of_v<std::shared_ptr<VerySpecialType>, SharedPtr<VerySpecialType>>));
 //
 //  assert((!std::is_base_of_v<std::weak_ptr<VerySpecialType>, WeakPtr<VerySpecialType>>));
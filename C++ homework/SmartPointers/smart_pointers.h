@@ -1,128 +1,232 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
 #include <iostream>
 #include <memory>
 
-template <typename U>
+// Reference count policies. AtomicRefCount makes SharedPtr and WeakPtr
+// copies of one object usable from different threads: increments are
+// relaxed since a new reference is always made from an existing one, and
+// decrements are acq_rel so that every use of the object happens before its
+// deletion, as in libstdc++. PlainRefCount is for objects that never leave
+// one thread and should not pay for atomic instructions. Both keep 32-bit
+// counts, so a control block is one pointer and two counts.
+struct AtomicRefCount {
+  using Count = std::atomic<uint32_t>;
+
+  static void Increment(Count& count) {
+    count.fetch_add(1, std::memory_order_relaxed);
+  }
+  // Returns the value before the decrement.
+  static size_t Decrement(Count& count) {
+    return count.fetch_sub(1, std::memory_order_acq_rel);
+  }
+  static bool IncrementIfNotZero(Count& count) {
+    uint32_t value = count.load(std::memory_order_relaxed);
+    while (value != 0) {
+      if (count.compare_exchange_weak(value, value + 1,
+                                      std::memory_order_acq_rel,
+                                      std::memory_order_relaxed)) {
+        return true;
+      }
+    }
+    return false;
+  }
+  static size_t Load(const Count& count) {
+    return count.load(std::memory_order_relaxed);
+  }
+  // Pairs with the release half of Decrement, for deciding to free memory
+  // that other threads have just stopped using.
+  static size_t LoadAcquire(const Count& count) {
+    return count.load(std::memory_order_acquire);
+  }
+};
+
+struct PlainRefCount {
+  using Count = uint32_t;
+
+  static void Increment(Count& count) { ++count; }
+  static size_t Decrement(Count& count) { return count--; }
+  static bool IncrementIfNotZero(Count& count) {
+    if (count == 0) {
+      return false;
+    }
+    ++count;
+    return true;
+  }
+  static size_t Load(const Count& count) { return count; }
+  static size_t LoadAcquire(const Count& count) { return count; }
+};
+
+template <typename U, typename Policy = AtomicRefCount>
 class EnableSharedFromThis;
 
-template <typename T>
+template <typename T, typename Policy = AtomicRefCount>
 class SharedPtr;
 
-template <class T, class Alloc, class... Args>
-SharedPtr<T> allocateShared(const Alloc& alloc, Args&&... args);
+template <typename T, typename Policy = AtomicRefCount>
+class WeakPtr;
+
+template <typename T>
+class AtomicSharedPtr;
 
-template <typename Y, typename... Args>
-SharedPtr<Y> makeShared(Args&&... args);
+// Thread-confined counterparts of SharedPtr and WeakPtr.
+template <typename T>
+using LocalSharedPtr = SharedPtr<T, PlainRefCount>;
+template <typename T>
+using LocalWeakPtr = WeakPtr<T, PlainRefCount>;
 
+template <typename T, typename Policy, typename Alloc, typename... Args>
+SharedPtr<T, Policy> allocateSharedWith(const Alloc& alloc, Args&&... args);
+
+// All shared owners together hold one extra weak reference, which makes the
+// last decrement of weak_count the single point that destroys the block.
+// Instead of a vtable every block carries the Manage function of its own
+// type, which keeps the block one pointer and two counts.
+template <typename Policy = AtomicRefCount>
 struct BaseControlBlock {
-  size_t shared_count = 0;
-  size_t weak_count = 0;
+  enum class Operation { kDelete, kDestroy, kDeleteAndDestroy };
+  using Manager = void (*)(BaseControlBlock*, Operation);
+
+  Manager manager;
+  typename Policy::Count shared_count = 0;
+  typename Policy::Count weak_count = 0;
+
+  BaseControlBlock(Manager manager, size_t shared_count, size_t weak_count)
+      : manager(manager),
+        shared_count(shared_count),
+        weak_count(weak_count + (shared_count != 0 ? 1 : 0)) {}
+
+  void AddShared() { Policy::Increment(shared_count); }
+  void AddWeak() { Policy::Increment(weak_count); }
 
-  BaseControlBlock(size_t shared_count, size_t weak_count)
-      : shared_count(shared_count), weak_count(weak_count) {}
+  // Used by WeakPtr::lock, which must not revive an expired object.
+  bool AddSharedIfNotZero() { return Policy::IncrementIfNotZero(shared_count); }
+
+  size_t UseCount() const { return Policy::Load(shared_count); }
 
   void FreeWeak() {
-    --weak_count;
-    if (weak_count == 0 && shared_count == 0) {
-      Destroy();
+    if (Policy::Decrement(weak_count) == 1) {
+      manager(this, Operation::kDestroy);
     }
   };
 
+  // When the owners' weak reference is the only one left, no WeakPtr exists
+  // and none can appear anymore, so the value and the block go in a single
+  // call. Otherwise the value has to die first: the weak reference keeps the
+  // block alive until then.
   void FreeShared() {
-    if (shared_count == 1) {
-      Delete();
-      --shared_count;
-      if (weak_count == 0) {
-        Destroy();
+    if (Policy::Decrement(shared_count) == 1) {
+      if (Policy::LoadAcquire(weak_count) == 1) {
+        manager(this, Operation::kDeleteAndDestroy);
+        return;
       }
-    } else {
-      --shared_count;
+      manager(this, Operation::kDelete);
+      FreeWeak();
     }
   };
-
-  virtual void Delete() = 0;
-  virtual void Destroy() { delete this; }
-  virtual ~BaseControlBlock() = default;
 };
 
-template <typename T, typename Allocator>
-struct SharedBlock : BaseControlBlock {
-  T value;
+template <typename T, typename Allocator, typename Policy = AtomicRefCount>
+struct SharedBlock : BaseControlBlock<Policy> {
+  using Base = BaseControlBlock<Policy>;
+
+  // The value dies before the block, so the block must not destroy it.
+  union {
+    T value;
+  };
   Allocator alloc;
 
+  template <typename... Args>
   SharedBlock(size_t shared_count, size_t weak_count, const Allocator& alloc,
-              T&& val)
-      : BaseControlBlock(shared_count, weak_count),
-        value(std::move(val)),
+              Args&&... args)
+      : Base(&Manage, shared_count, weak_count),
+        value(std::forward<Args>(args)...),
         alloc(alloc) {}
-
-  SharedBlock(size_t shared_count, size_t weak_count, const Allocator& alloc)
-      : BaseControlBlock(shared_count, weak_count), alloc(alloc) {}
-
-  void Delete() override {
-    std::allocator_traits<Allocator>::destroy(alloc, &value);
-  }
-
-  void Destroy() override {
+  ~SharedBlock() {}
+
+  static void Manage(Base* base, typename Base::Operation operation) {
+    auto* block = static_cast<SharedBlock*>(base);
+    if (operation != Base::Operation::kDestroy) {
+      std::allocator_traits<Allocator>::destroy(block->alloc, &block->value);
+      if (operation == Base::Operation::kDelete) {
+        return;
+      }
+    }
     typename std::allocator_traits<Allocator>::template rebind_alloc<
-        SharedBlock>(alloc)
-        .deallocate(this, 1);
+        SharedBlock>
+        block_alloc(block->alloc);
+    block->~SharedBlock();
+    block_alloc.deallocate(block, 1);
   }
 
   T* get_ptr() { return &value; }
 };
 
 template <typename T, typename Deleter = std::default_delete<T>,
-          typename Allocator = std::allocator<T>>
-struct ControlBlock : BaseControlBlock {
+          typename Allocator = std::allocator<T>,
+          typename Policy = AtomicRefCount>
+struct ControlBlock : BaseControlBlock<Policy> {
+  using Base = BaseControlBlock<Policy>;
+
   T* pointer;
   Deleter del;
   Allocator alloc;
 
   ControlBlock(size_t shared_count, size_t weak_count, T* ptr,
                const Deleter& del, const Allocator& alloc)
-      : BaseControlBlock(shared_count, weak_count),
+      : Base(&Manage, shared_count, weak_count),
         pointer(ptr),
         del(del),
         alloc(alloc) {}
 
-  void Delete() override { del(pointer); }
-
-  void Destroy() override {
+  static void Manage(Base* base, typename Base::Operation operation) {
+    auto* block = static_cast<ControlBlock*>(base);
+    if (operation != Base::Operation::kDestroy) {
+      block->del(block->pointer);
+      if (operation == Base::Operation::kDelete) {
+        return;
+      }
+    }
     typename std::allocator_traits<Allocator>::template rebind_alloc<
-        ControlBlock>(alloc)
-        .deallocate(this, 1);
+        ControlBlock>
+        block_alloc(block->alloc);
+    block->~ControlBlock();
+    block_alloc.deallocate(block, 1);
   }
 };
-template <typename T>
-class WeakPtr;
 
-template <typename T>
+template <typename T, typename Policy>
 class SharedPtr {
  private:
-  BaseControlBlock* cb_ptr_ = nullptr;
+  BaseControlBlock<Policy>* cb_ptr_ = nullptr;
   T* ptr_ = nullptr;
 
   template <typename Deleter, typename Allocator>
   auto allocate_construct_cb(T* pointer, const Deleter& del,
                              const Allocator& alloc) {
+    using Block = ControlBlock<T, Deleter, Allocator, Policy>;
     auto ptr = typename std::allocator_traits<Allocator>::template rebind_alloc<
-                   ControlBlock<T, Deleter, Allocator>>(alloc)
+                   Block>(alloc)
                    .allocate(1);
-    new (ptr) ControlBlock<T, Deleter, Allocator>(1, 0, pointer, del, alloc);
+    new (ptr) Block(1, 0, pointer, del, alloc);
     return ptr;
   }
 
-  SharedPtr(const WeakPtr<T>& weak_ptr)
-      : cb_ptr_(weak_ptr.cb_ptr_), ptr_(weak_ptr.ptr_) {
-    if (cb_ptr_ != nullptr) {
-      ++cb_ptr_->shared_count;
+  // Null if the object is already gone.
+  SharedPtr(const WeakPtr<T, Policy>& weak_ptr) {
+    if (weak_ptr.cb_ptr_ != nullptr &&
+        weak_ptr.cb_ptr_->AddSharedIfNotZero()) {
+      cb_ptr_ = weak_ptr.cb_ptr_;
+      ptr_ = weak_ptr.ptr_;
     }
   }
 
   template <typename Allocator>
-  SharedPtr(SharedBlock<T, Allocator>* cb_pointer)
+  SharedPtr(SharedBlock<T, Allocator, Policy>* cb_pointer)
       : cb_ptr_(cb_pointer), ptr_(cb_pointer->get_ptr()) {
-    if constexpr (std::is_base_of_v<EnableSharedFromThis<T>, T>) {
+    if constexpr (std::is_base_of_v<EnableSharedFromThis<T, Policy>, T>) {
       cb_pointer->value.weak_ptr_ = *this;
     }
   }
@@ -133,7 +237,7 @@ class SharedPtr {
   template <typename U, typename Deleter, typename Allocator>
   SharedPtr(U* pointer, const Deleter& del, const Allocator& alloc)
       : cb_ptr_(allocate_construct_cb(pointer, del, alloc)), ptr_(pointer) {
-    if constexpr (std::is_base_of_v<EnableSharedFromThis<T>, T>) {
+    if constexpr (std::is_base_of_v<EnableSharedFromThis<T, Policy>, T>) {
       pointer->weak_ptr_ = *this;
     }
   }
@@ -149,20 +253,20 @@ class SharedPtr {
   SharedPtr(const SharedPtr& other_ptr)
       : cb_ptr_(other_ptr.cb_ptr_), ptr_(other_ptr.ptr_) {
     if (cb_ptr_ != nullptr) {
-      ++cb_ptr_->shared_count;
+      cb_ptr_->AddShared();
     }
   }
 
   template <typename U>
-  SharedPtr(const SharedPtr<U>& other_ptr)
+  SharedPtr(const SharedPtr<U, Policy>& other_ptr)
       : cb_ptr_(other_ptr.cb_ptr_), ptr_(other_ptr.ptr_) {
     if (cb_ptr_ != nullptr) {
-      ++cb_ptr_->shared_count;
+      cb_ptr_->AddShared();
     }
   }
 
   template <typename U>
-  SharedPtr(SharedPtr<U>&& other_ptr)
+  SharedPtr(SharedPtr<U, Policy>&& other_ptr)
       : cb_ptr_(other_ptr.cb_ptr_), ptr_(other_ptr.ptr_) {
     other_ptr.cb_ptr_ = nullptr;
     other_ptr.ptr_ = nullptr;
@@ -174,26 +278,26 @@ class SharedPtr {
   }
 
   SharedPtr& operator=(const SharedPtr& other_ptr) {
-    auto tmp = SharedPtr<T>(other_ptr);
+    auto tmp = SharedPtr(other_ptr);
     swap(tmp);
     return *this;
   }
 
   template <typename U>
-  SharedPtr& operator=(SharedPtr<U>&& other_ptr) {
-    SharedPtr<T>(std::move(other_ptr)).swap(*this);
+  SharedPtr& operator=(SharedPtr<U, Policy>&& other_ptr) {
+    SharedPtr(std::move(other_ptr)).swap(*this);
     return *this;
   }
 
   template <typename Y>
   void reset(Y* ptr) {
-    SharedPtr<Y>(ptr).swap(*this);
+    SharedPtr<Y, Policy>(ptr).swap(*this);
   }
 
   void reset() { SharedPtr().swap(*this); }
 
   size_t use_count() const {
-    return (cb_ptr_ == nullptr ? 0 : cb_ptr_->shared_count);
+    return (cb_ptr_ == nullptr ? 0 : cb_ptr_->UseCount());
   }
 
   ~SharedPtr() {
@@ -209,22 +313,23 @@ class SharedPtr {
   T* get() const { return ptr_; }
 
  private:
-  template <typename U>
+  template <typename U, typename P>
   friend class SharedPtr;
 
-  template <typename U>
+  template <typename U, typename P>
   friend class WeakPtr;
 
-  template <typename Y, typename Alloc, typename... Args>
-  friend SharedPtr<Y> allocateShared(const Alloc& alloc, Args&&... args);
+  template <typename U>
+  friend class AtomicSharedPtr;
 
-  template <typename Y, typename... Args>
-  friend SharedPtr<Y> makeShared(Args&&... args);
+  template <typename Y, typename P, typename Alloc, typename... Args>
+  friend SharedPtr<Y, P> allocateSharedWith(const Alloc& alloc,
+                                            Args&&... args);
 };
 
-template <class T, class Alloc, class... Args>
-SharedPtr<T> allocateShared(const Alloc& alloc, Args&&... args) {
-  using Block = SharedBlock<T, Alloc>;
+template <typename T, typename Policy, typename Alloc, typename... Args>
+SharedPtr<T, Policy> allocateSharedWith(const Alloc& alloc, Args&&... args) {
+  using Block = SharedBlock<T, Alloc, Policy>;
   using BlockAlloc =
       typename std::allocator_traits<Alloc>::template rebind_alloc<Block>;
   using BlockTraits = std::allocator_traits<BlockAlloc>;
@@ -239,7 +344,13 @@ SharedPtr<T> allocateShared(const Alloc& alloc, Args&&... args) {
     BlockTraits::deallocate(block_alloc, block, 1);
     throw;
   }
-  return SharedPtr<T>(block);
+  return SharedPtr<T, Policy>(block);
+}
+
+template <class T, class Alloc, class... Args>
+SharedPtr<T> allocateShared(const Alloc& alloc, Args&&... args) {
+  return allocateSharedWith<T, AtomicRefCount>(alloc,
+                                               std::forward<Args>(args)...);
 }
 
 template <typename T, typename... Args>
@@ -248,66 +359,78 @@ SharedPtr<T> makeShared(Args&&... args) {
       std::allocator<T>(), std::forward<Args>(args)...);
 }
 
-template <typename T>
+template <class T, class Alloc, class... Args>
+LocalSharedPtr<T> allocateLocalShared(const Alloc& alloc, Args&&... args) {
+  return allocateSharedWith<T, PlainRefCount>(alloc,
+                                              std::forward<Args>(args)...);
+}
+
+template <typename T, typename... Args>
+LocalSharedPtr<T> makeLocalShared(Args&&... args) {
+  return allocateLocalShared<T, std::allocator<T>, Args...>(
+      std::allocator<T>(), std::forward<Args>(args)...);
+}
+
+template <typename T, typename Policy>
 class WeakPtr {
  private:
-  BaseControlBlock* cb_ptr_ = nullptr;
+  BaseControlBlock<Policy>* cb_ptr_ = nullptr;
   T* ptr_ = nullptr;
 
-  template <typename U>
+  template <typename U, typename P>
   friend class WeakPtr;
 
-  template <typename U>
+  template <typename U, typename P>
   friend class SharedPtr;
 
  public:
   WeakPtr() : cb_ptr_(nullptr), ptr_(nullptr){};
 
   template <typename U>
-  WeakPtr(SharedPtr<U>& other_ptr)
+  WeakPtr(SharedPtr<U, Policy>& other_ptr)
       : cb_ptr_(other_ptr.cb_ptr_), ptr_(other_ptr.ptr_) {
     if (cb_ptr_ != nullptr) {
-      ++cb_ptr_->weak_count;
+      cb_ptr_->AddWeak();
     }
   }
 
   template <typename U>
-  WeakPtr(WeakPtr<U>& other_ptr)
+  WeakPtr(WeakPtr<U, Policy>& other_ptr)
       : cb_ptr_(other_ptr.cb_ptr_), ptr_(other_ptr.ptr_) {
     if (cb_ptr_ != nullptr) {
-      ++cb_ptr_->weak_count;
+      cb_ptr_->AddWeak();
     }
   }
 
   template <typename U>
-  WeakPtr(WeakPtr<U>&& other_ptr)
+  WeakPtr(WeakPtr<U, Policy>&& other_ptr)
       : cb_ptr_(other_ptr.cb_ptr_), ptr_(other_ptr.ptr_) {
     other_ptr.cb_ptr_ = nullptr;
     other_ptr.ptr_ = nullptr;
   }
 
   template <typename U>
-  void swap(WeakPtr<U>& other_ptr) {
+  void swap(WeakPtr<U, Policy>& other_ptr) {
     std::swap(cb_ptr_, other_ptr.cb_ptr_);
     std::swap(ptr_, other_ptr.ptr_);
   }
 
   template <typename U>
-  WeakPtr& operator=(WeakPtr<U>& other) {
-    auto tmp = WeakPtr<T>(other);
+  WeakPtr& operator=(WeakPtr<U, Policy>& other) {
+    auto tmp = WeakPtr(other);
     swap(tmp);
     return *this;
   }
 
   template <typename U>
-  WeakPtr& operator=(SharedPtr<U>& other) {
-    WeakPtr<T>(other).swap(*this);
+  WeakPtr& operator=(SharedPtr<U, Policy>& other) {
+    WeakPtr(other).swap(*this);
     return *this;
   }
 
   template <typename U>
   WeakPtr& operator=(WeakPtr&& other) {
-    WeakPtr<T>(std::move(other)).swap(*this);
+    WeakPtr(std::move(other)).swap(*this);
     return *this;
   }
 
@@ -318,31 +441,29 @@ class WeakPtr {
   }
 
   size_t use_count() const {
-    return (cb_ptr_ == nullptr ? 0 : cb_ptr_->shared_count);
+    return (cb_ptr_ == nullptr ? 0 : cb_ptr_->UseCount());
   }
   bool expired() const { return use_count() == 0; }
 
-  SharedPtr<T> lock() const {
-    return (expired() ? SharedPtr<T>() : SharedPtr<T>(*this));
-  }
+  SharedPtr<T, Policy> lock() const { return SharedPtr<T, Policy>(*this); }
 };
 
-template <typename T>
+template <typename T, typename Policy>
 class EnableSharedFromThis {
  private:
-  WeakPtr<T> weak_ptr_;
+  WeakPtr<T, Policy> weak_ptr_;
 
-  template <typename U>
+  template <typename U, typename P>
   friend class SharedPtr;
 
  protected:
   EnableSharedFromThis() = default;
 
  public:
-  SharedPtr<T> shared_from_this() {
+  SharedPtr<T, Policy> shared_from_this() {
     if (weak_ptr_.expired()) {
       throw std::bad_weak_ptr();
     }
     return weak_ptr_.lock();
   }
-};
\ No newline at end of file
+};
@@ -0,0 +1,219 @@
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "atomic_shared_ptr.h"
+#include "intrusive_ptr.h"
+#include "smart_pointers.h"
+
+// Reference counting throughput of SharedPtr and WeakPtr under contention.
+// Every run makes kOperations copies in total, split evenly between the
+// threads, either of one pointer per thread or of one pointer shared by
+// all of them. A second table compares the atomic and plain reference
+// count policies on copy-heavy work confined to one thread, and a third one
+// times the last release of a pointer, which runs the control block's
+// destruction path. The last one compares readers of a published snapshot
+// through AtomicSharedPtr with readers of a mutex-guarded SharedPtr, and
+// the final table puts IntrusivePtr next to SharedPtr.
+
+constexpr size_t kOperations = 20'000'000;
+
+enum class Mode { kPrivate, kShared, kLock };
+
+double Run(Mode mode, size_t threads_count) {
+  auto shared = makeShared<int>(42);
+  WeakPtr<int> weak = shared;
+  size_t per_thread = kOperations / threads_count;
+
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < threads_count; ++t) {
+    threads.emplace_back([&, per_thread] {
+      SharedPtr<int> own = makeShared<int>(42);
+      const SharedPtr<int>& source = mode == Mode::kPrivate ? own : shared;
+      int sum = 0;
+      for (size_t i = 0; i < per_thread; ++i) {
+        if (mode == Mode::kLock) {
+          sum += *weak.lock();
+        } else {
+          SharedPtr<int> copy = source;
+          sum += *copy;
+        }
+      }
+      if (sum == 0) {
+        std::printf("unreachable\n");
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  auto finish = std::chrono::steady_clock::now();
+  double seconds = std::chrono::duration<double>(finish - start).count();
+  return per_thread * threads_count / seconds / 1e6;
+}
+
+// Copies a vector of kGraphSize pointers over and over, the way a graph
+// algorithm copies adjacency lists, and returns million copies per second.
+template <typename Policy>
+double RunConfined() {
+  constexpr size_t kGraphSize = 1'000;
+  std::vector<SharedPtr<int, Policy>> nodes;
+  for (size_t i = 0; i < kGraphSize; ++i) {
+    nodes.push_back(allocateSharedWith<int, Policy>(std::allocator<int>(),
+                                                    static_cast<int>(i)));
+  }
+  size_t sum = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (size_t round = 0; round < kOperations / kGraphSize; ++round) {
+    std::vector<SharedPtr<int, Policy>> copy = nodes;
+    sum += *copy[round % kGraphSize];
+  }
+  auto finish = std::chrono::steady_clock::now();
+  if (sum == 0) {
+    std::printf("unreachable\n");
+  }
+  double seconds = std::chrono::duration<double>(finish - start).count();
+  return kOperations / seconds / 1e6;
+}
+
+// Creates and releases kReleases pointers to the same kind of block that
+// make_block builds, one at a time.
+constexpr size_t kReleases = 5'000'000;
+
+template <typename MakeBlock>
+double RunRelease(MakeBlock make_block) {
+  auto start = std::chrono::steady_clock::now();
+  size_t sum = 0;
+  for (size_t i = 0; i < kReleases; ++i) {
+    SharedPtr<int> ptr = make_block(static_cast<int>(i));
+    sum += *ptr;
+  }
+  auto finish = std::chrono::steady_clock::now();
+  if (sum == 0) {
+    std::printf("unreachable\n");
+  }
+  double seconds = std::chrono::duration<double>(finish - start).count();
+  return kReleases / seconds / 1e6;
+}
+
+class LockedSlot {
+ public:
+  explicit LockedSlot(SharedPtr<int> value) : value_(std::move(value)) {}
+  SharedPtr<int> load() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return value_;
+  }
+  void store(SharedPtr<int> value) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    value_.swap(value);
+  }
+
+ private:
+  mutable std::mutex mutex_;
+  SharedPtr<int> value_;
+};
+
+// Every thread loads the snapshot kOperations / threads_count times; the
+// first one also publishes a new snapshot every 1000 loads.
+template <typename Slot>
+double RunPublication(size_t threads_count) {
+  Slot slot(makeShared<int>(0));
+  size_t per_thread = kOperations / threads_count;
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < threads_count; ++t) {
+    threads.emplace_back([&slot, per_thread, t] {
+      size_t sum = 0;
+      for (size_t i = 0; i < per_thread; ++i) {
+        if (t == 0 && i % 1000 == 0) {
+          slot.store(makeShared<int>(static_cast<int>(i)));
+        }
+        sum += *slot.load();
+      }
+      if (sum == 1) {
+        std::printf("unreachable\n");
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  auto finish = std::chrono::steady_clock::now();
+  double seconds = std::chrono::duration<double>(finish - start).count();
+  return per_thread * threads_count / seconds / 1e6;
+}
+
+struct Message : public RefCounted<Message> {
+  int value = 1;
+};
+
+// Creates kReleases messages and copies each of them kCopiesPerMessage
+// times into a vector of handles, returning million handles per second.
+template <typename Make>
+double RunHandles(Make make) {
+  constexpr size_t kCopiesPerMessage = 4;
+  using Handle = decltype(make());
+  std::vector<Handle> handles(kCopiesPerMessage);
+  size_t sum = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < kReleases; ++i) {
+    Handle message = make();
+    for (Handle& handle : handles) {
+      handle = message;
+      sum += handle->value;
+    }
+  }
+  auto finish = std::chrono::steady_clock::now();
+  if (sum == 0) {
+    std::printf("unreachable\n");
+  }
+  double seconds = std::chrono::duration<double>(finish - start).count();
+  return kReleases * (kCopiesPerMessage + 1) / seconds / 1e6;
+}
+
+int main() {
+  std::printf("%-8s %14s %14s %14s\n", "threads", "private copy",
+              "shared copy", "weak lock");
+  for (size_t threads = 1; threads <= 8; threads *= 2) {
+    std::printf("%-8zu %14.2f %14.2f %14.2f\n", threads,
+                Run(Mode::kPrivate, threads), Run(Mode::kShared, threads),
+                Run(Mode::kLock, threads));
+  }
+  std::printf("(million copies per second)\n\n");
+
+  std::printf("%-8s %14s %14s\n", "policy", "atomic", "plain");
+  std::printf("%-8s %14.2f %14.2f\n", "confined", RunConfined<AtomicRefCount>(),
+              RunConfined<PlainRefCount>());
+  std::printf("(million copies per second, one thread)\n\n");
+
+  std::printf("%-8s %14s %14s\n", "release", "makeShared", "new");
+  auto inline_block = [](int value) { return makeShared<int>(value); };
+  auto separate_block = [](int value) {
+    return SharedPtr<int>(new int(value));
+  };
+  std::printf("%-8s %14.2f %14.2f\n", "", RunRelease(inline_block),
+              RunRelease(separate_block));
+  std::printf("(million pointers created and released per second)\n\n");
+
+  std::printf("%-8s %14s %14s\n", "threads", "atomic slot", "mutex slot");
+  for (size_t threads = 1; threads <= 8; threads *= 2) {
+    std::printf("%-8zu %14.2f %14.2f\n", threads,
+                RunPublication<AtomicSharedPtr<int>>(threads),
+                RunPublication<LockedSlot>(threads));
+  }
+  std::printf("(million snapshot loads per second)\n\n");
+
+  std::printf("%-10s %14s %14s %14s\n", "handle", "IntrusivePtr",
+              "makeShared", "SharedPtr(new)");
+  std::printf("%-10s %14zu %14zu %14zu\n", "size",
+              sizeof(IntrusivePtr<Message>), sizeof(SharedPtr<Message>),
+              sizeof(SharedPtr<Message>));
+  std::printf("%-10s %14.2f %14.2f %14.2f\n", "speed",
+              RunHandles([] { return makeIntrusive<Message>(); }),
+              RunHandles([] { return makeShared<Message>(); }),
+              RunHandles([] { return SharedPtr<Message>(new Message()); }));
+  std::printf("(handle size in bytes; million handles made per second)\n");
+}